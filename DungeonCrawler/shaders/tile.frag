@@ -2,16 +2,34 @@
 
 //Input from Vert Shader
 in vec2 uv_vert;
+in vec3 world_pos_vert;
+in vec3 light_vert;
 
 //Uniforms
 uniform sampler2D main_tex;
 uniform vec4 color;
 
+//Fog of war, xy is the world position of the window's corner and zw its size in tiles
+uniform bool fog_enabled;
+uniform sampler2D visibility_tex;
+uniform vec4 visibility_rect;
+
 //Output
 out vec4 FragColor;
 
 void main()
 {
 	FragColor = texture(main_tex, uv_vert) * color;
+
+	//Baked ambient occlusion and torch light
+	FragColor.rgb *= light_vert;
+
+	//Explored tiles that are out of sight are dimmed
+	if (fog_enabled)
+	{
+		float visible = texture(visibility_tex, (world_pos_vert.xz - visibility_rect.xy) / visibility_rect.zw).r;
+		FragColor.rgb *= mix(0.3, 1.0, visible);
+	}
+
 	//FragColor = vec4(uv_vert, 0.0, 1.0);
 }
@@ -3,6 +3,7 @@
 //Vert data
 layout (location = 0) in vec3 pos_in;
 layout (location = 1) in vec2 uv_in;
+layout (location = 2) in vec3 light_in;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -10,9 +11,14 @@ uniform mat4 projection;
 
 //Output
 out vec2 uv_vert;
+out vec3 world_pos_vert;
+out vec3 light_vert;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(pos_in, 1.0);
+	vec4 worldPos = model * vec4(pos_in, 1.0);
+	gl_Position = projection * view * worldPos;
 	uv_vert = uv_in;
+	world_pos_vert = worldPos.xyz;
+	light_vert = light_in;
 }
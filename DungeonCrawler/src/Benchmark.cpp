@@ -0,0 +1,325 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <iostream>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include "Benchmark.h"
+#include "Map.h"
+#include "Pathfinding.h"
+#include "LevelFile.h"
+#include "LevelGenerator.h"
+#include "Entities.h"
+#include "FieldOfView.h"
+#include "Lighting.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void FillMapRandom(unsigned int seed)
+{
+	std::mt19937_64 random(seed);
+	unsigned int width = GetMapWidth();
+
+	for (unsigned int y = 0; y < GetMapHeight(); y++)
+	{
+		unsigned long long* row = GetMapPathRow(y);
+
+		for (unsigned int w = 0; w < GetMapRowWords(); w++)
+		{
+			row[w] = random();
+		}
+
+		//Keep bits past the right edge of the map clear
+		if (width % 64 != 0)
+		{
+			row[GetMapRowWords() - 1] &= (1ull << (width % 64)) - 1;
+		}
+	}
+}
+
+static void BenchmarkClassification(unsigned int width, unsigned int height, int runs)
+{
+	ResizeMap(width, height);
+	FillMapRandom(width ^ height);
+
+	double best = 0.0;
+
+	for (int i = 0; i < runs; i++)
+	{
+		Clock::time_point start = Clock::now();
+		ClassifyMap();
+		double time = MillisecondsSince(start);
+
+		if (i == 0 || time < best)
+		{
+			best = time;
+		}
+	}
+
+	std::cout << "Classify " << width << "x" << height << ": " << best << " ms\n";
+}
+
+static void BenchmarkEdits(unsigned int width, unsigned int height, int edits)
+{
+	ResizeMap(width, height);
+	FillMapRandom(width ^ height);
+	ClassifyMap();
+
+	std::mt19937 random(edits);
+	Clock::time_point start = Clock::now();
+
+	for (int i = 0; i < edits; i++)
+	{
+		SetMapPath(random() % width, random() % height, random() % 2 == 0);
+	}
+
+	double time = MillisecondsSince(start);
+	std::cout << "Edit " << width << "x" << height << ": " << time * 1000.0 / edits << " us per edit\n";
+}
+
+static glm::ivec2 RandomPathTile(std::mt19937& random)
+{
+	while (true)
+	{
+		unsigned int x = random() % GetMapWidth();
+		unsigned int y = random() % GetMapHeight();
+
+		if (IsMapPath(x, y))
+		{
+			return glm::ivec2(x, y);
+		}
+	}
+}
+
+static void BenchmarkPathfinding(unsigned int size, unsigned int queryCount, unsigned int agentCount)
+{
+	GenerateLevel(Maze, size, size, size);
+
+	std::mt19937 random(queryCount);
+	std::vector<PathQuery> queries(queryCount);
+
+	for (PathQuery& query : queries)
+	{
+		glm::ivec2 start = RandomPathTile(random);
+		glm::ivec2 goal = RandomPathTile(random);
+		query = PathQuery{ (unsigned int)start.x, (unsigned int)start.y, (unsigned int)goal.x, (unsigned int)goal.y };
+	}
+
+	std::vector<PathResult> results(queryCount);
+	const char* names[2] = { "A*", "JPS" };
+	PathAlgorithm algorithms[2] = { AStar, JumpPoint };
+
+	for (int i = 0; i < 2; i++)
+	{
+		Clock::time_point start = Clock::now();
+		FindPaths(queries.data(), results.data(), queryCount, algorithms[i]);
+		double time = MillisecondsSince(start);
+
+		std::cout << names[i] << " " << size << "x" << size << " maze: " << queryCount << " queries in " << time << " ms\n";
+	}
+
+	//One shared field answers every agent chasing the same goal
+	glm::ivec2 goal = RandomPathTile(random);
+	FlowField field;
+	Clock::time_point start = Clock::now();
+	BuildFlowField(field, goal.x, goal.y);
+	std::cout << "Flow field " << size << "x" << size << " maze: " << MillisecondsSince(start) << " ms\n";
+
+	std::vector<glm::ivec2> agents(agentCount);
+
+	for (glm::ivec2& agent : agents)
+	{
+		agent = RandomPathTile(random);
+	}
+
+	const int directionX[4] = { 1, 0, -1, 0 };
+	const int directionY[4] = { 0, 1, 0, -1 };
+
+	start = Clock::now();
+
+	for (glm::ivec2& agent : agents)
+	{
+		unsigned char direction = GetFlowDirection(field, agent.x, agent.y);
+
+		if (direction != FLOW_NO_DIRECTION)
+		{
+			agent += glm::ivec2(directionX[direction], directionY[direction]);
+		}
+	}
+
+	std::cout << "Flow step " << agentCount << " agents: " << MillisecondsSince(start) << " ms\n";
+}
+
+static void BenchmarkGeneration(LevelLayout layout, const char* name, unsigned int size)
+{
+	Clock::time_point start = Clock::now();
+	GenerateLevelPaths(layout, size, size, size);
+	double generateTime = MillisecondsSince(start);
+
+	start = Clock::now();
+	ClassifyMap();
+	double classifyTime = MillisecondsSince(start);
+
+	double millions = (double)size * size / 1000000.0;
+	std::cout << "Generate " << name << " " << size << "x" << size << ": " << generateTime / millions << " ms per million tiles, classify "
+		<< classifyTime / millions << " ms per million tiles\n";
+}
+
+static void BenchmarkEntities(unsigned int size, unsigned int count, int ticks)
+{
+	GenerateLevel(Caves, size, size, count);
+	ClearEntities();
+
+	std::mt19937 random(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		glm::ivec2 tile = RandomPathTile(random);
+		CreateEntity(tile.x, tile.y, random() % 4, i % 2 == 0 ? WanderBrain : ChaseBrain);
+	}
+
+	//Everyone chases the first wanderer, so the field gets rebuilt as it moves
+	SetEntityChaseTarget(0);
+
+	Clock::time_point start = Clock::now();
+
+	for (int i = 0; i < ticks; i++)
+	{
+		TickEntities(1.f / 30.f);
+	}
+
+	std::cout << "Tick " << count << " entities: " << MillisecondsSince(start) / ticks << " ms per tick\n";
+	ClearEntities();
+}
+
+static void BenchmarkFieldOfView(LevelLayout layout, const char* name, unsigned int size, unsigned int radius, unsigned int count)
+{
+	GenerateLevel(layout, size, size, size);
+
+	std::mt19937 random(count);
+	std::vector<glm::ivec2> origins(count);
+
+	for (glm::ivec2& origin : origins)
+	{
+		origin = RandomPathTile(random);
+	}
+
+	FieldOfView view;
+	Clock::time_point start = Clock::now();
+
+	for (glm::ivec2& origin : origins)
+	{
+		ComputeFieldOfView(view, origin.x, origin.y, radius);
+	}
+
+	std::cout << "Field of view " << name << " " << size << "x" << size << " radius " << radius << ": " << MillisecondsSince(start) * 1000.0 / count << " us\n";
+}
+
+static void BenchmarkLighting(LevelLayout layout, const char* name, unsigned int size, int edits)
+{
+	GenerateLevel(layout, size, size, size);
+
+	Clock::time_point start = Clock::now();
+	BakeLighting();
+	double time = MillisecondsSince(start);
+	std::cout << "Bake lighting " << name << " " << size << "x" << size << ": " << time << " ms ("
+		<< time / ((double)size * size / 1000000.0) << " ms per million tiles)\n";
+
+	//Edits on a lit map also rebake the light around them
+	std::mt19937 random(edits);
+	start = Clock::now();
+
+	for (int i = 0; i < edits; i++)
+	{
+		SetMapPath(1 + random() % (size - 2), 1 + random() % (size - 2), random() % 2 == 0);
+	}
+
+	std::cout << "Lit edit " << size << "x" << size << ": " << MillisecondsSince(start) * 1000.0 / edits << " us per edit\n";
+}
+
+static void BenchmarkLevelFiles(unsigned int width, unsigned int height)
+{
+	ResizeMap(width, height);
+	FillMapRandom(width + height);
+	ClassifyMap();
+
+	//Write the same level out in both formats
+	const char* textPath = "benchmark_level.txt";
+	const char* binaryPath = "benchmark_level.lvl";
+	FILE* file = fopen(textPath, "wb");
+	std::vector<char> line(width + 1, '\n');
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			line[x] = IsMapPath(x, y) ? '*' : ' ';
+		}
+
+		fwrite(line.data(), 1, line.size(), file);
+	}
+
+	fclose(file);
+	SaveLevelBinary(binaryPath);
+
+	//The format loaders directly, LoadLevel would also bake or read the lighting cache
+	Clock::time_point start = Clock::now();
+	ImportLevelText(textPath);
+	ClassifyMap();
+	std::cout << "Load text " << width << "x" << height << ": " << MillisecondsSince(start) << " ms\n";
+
+	start = Clock::now();
+	LoadLevelBinary(binaryPath);
+	std::cout << "Load binary " << width << "x" << height << ": " << MillisecondsSince(start) << " ms\n";
+
+	remove(textPath);
+	remove(binaryPath);
+}
+
+void RunBenchmarks()
+{
+	BenchmarkClassification(64, 64, 10);
+	BenchmarkClassification(1024, 1024, 10);
+	BenchmarkClassification(4096, 4096, 5);
+
+	//Edit cost should stay flat as the map grows
+	BenchmarkEdits(64, 64, 100000);
+	BenchmarkEdits(4096, 4096, 100000);
+
+	BenchmarkLevelFiles(1024, 1024);
+	BenchmarkLevelFiles(4096, 4096);
+
+	//Per million tile costs should stay flat from the smallest to the largest maps
+	const unsigned int generationSizes[4] = { 64, 1024, 4096, 16384 };
+
+	for (unsigned int size : generationSizes)
+	{
+		BenchmarkGeneration(RoomsAndCorridors, "rooms", size);
+		BenchmarkGeneration(BinarySpacePartition, "bsp", size);
+		BenchmarkGeneration(Caves, "caves", size);
+		BenchmarkGeneration(Maze, "maze", size);
+	}
+
+	//Cost depends on the radius, not the map size
+	BenchmarkFieldOfView(Caves, "caves", 256, 12, 10000);
+	BenchmarkFieldOfView(Caves, "caves", 4096, 12, 10000);
+	BenchmarkFieldOfView(RoomsAndCorridors, "rooms", 4096, 12, 10000);
+	BenchmarkFieldOfView(RoomsAndCorridors, "rooms", 4096, 32, 10000);
+
+	BenchmarkLighting(RoomsAndCorridors, "rooms", 1024, 1000);
+	BenchmarkLighting(Caves, "caves", 1024, 1000);
+
+	BenchmarkEntities(1024, 10000, 300);
+	BenchmarkEntities(1024, 100000, 100);
+
+	BenchmarkPathfinding(257, 1000, 10000);
+	BenchmarkPathfinding(1025, 100, 100000);
+
+	//Leave an empty map behind
+	ResizeMap(0, 0);
+}
\ No newline at end of file
@@ -0,0 +1,494 @@
+#include <glad.h>
+#include "glm/gtc/type_ptr.hpp"
+#include <vector>
+#include <algorithm>
+
+#include "Entities.h"
+#include "Map.h"
+#include "Pathfinding.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "Camera.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+using glm::vec3;
+using glm::ivec2;
+using glm::mat4;
+
+//At least this many entities are ticked on multiple threads
+#define PARALLEL_TICK_ENTITIES 4096
+//Tweens take 1 / TWEEN_SPEED seconds
+#define TWEEN_SPEED 2.f
+#define CHASE_SIGHT_RADIUS 8
+
+#define ENTITY_INDEX(entity) ((entity) & (MAX_ENTITIES - 1))
+#define ENTITY_GENERATION(entity) ((entity) >> ENTITY_INDEX_BITS)
+#define MAKE_ENTITY(index, generation) ((index) | ((generation) << ENTITY_INDEX_BITS))
+
+//Slots map handles to dense component rows, freed slots are reused with a new generation
+static std::vector<unsigned int> slotGenerations;
+static std::vector<unsigned int> slotRows;
+static std::vector<unsigned int> freeSlots;
+
+//Components, one row per live entity, packed so systems walk contiguous memory.
+//Destroying an entity moves the last row into its place.
+static std::vector<Entity> rowEntities;
+static std::vector<unsigned int> cellX, cellY, prevCellX, prevCellY;
+static std::vector<int> facing, prevFacing;
+static std::vector<float> tweenTimer, prevTweenTimer;
+static std::vector<unsigned char> brains;
+static std::vector<unsigned int> brainRandom;
+//Only chasers fill in their sight, it stays empty for everyone else
+static std::vector<FieldOfView> sight;
+
+static unsigned int chaserCount;
+static Entity chaseTarget = NULL_ENTITY;
+static FlowField chaseField;
+static bool chaseFieldReady = false;
+static glm::ivec2 chaseTargetCell;
+
+static unsigned int entityShader;
+static unsigned int modelMatrixUniform;
+static unsigned int viewMatrixUniform;
+static unsigned int projMatrixUniform;
+static unsigned int textureUniform;
+static unsigned int colorUniform;
+static unsigned int entityTexture;
+static unsigned int entityVAO, entityVBO;
+
+void InitializeEntities()
+{
+	//Entities are drawn with the tile shader, tinted
+	unsigned int vert = CreateShader(VertShader, "shaders/tile.vert");
+	unsigned int frag = CreateShader(FragShader, "shaders/tile.frag");
+	entityShader = CreateShaderProgram(vert, frag);
+	modelMatrixUniform = glGetUniformLocation(entityShader, "model");
+	viewMatrixUniform = glGetUniformLocation(entityShader, "view");
+	projMatrixUniform = glGetUniformLocation(entityShader, "projection");
+	textureUniform = glGetUniformLocation(entityShader, "main_tex");
+	colorUniform = glGetUniformLocation(entityShader, "color");
+
+	entityTexture = LoadTexture("textures/ground.jpg");
+
+	glGenVertexArrays(1, &entityVAO);
+	glBindVertexArray(entityVAO);
+	glGenBuffers(1, &entityVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, entityVBO);
+
+	//Set up vertex attributes (position, uv)
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+
+	glBindVertexArray(0);
+}
+
+void ClearEntities()
+{
+	slotGenerations.clear();
+	slotRows.clear();
+	freeSlots.clear();
+	rowEntities.clear();
+	cellX.clear();
+	cellY.clear();
+	prevCellX.clear();
+	prevCellY.clear();
+	facing.clear();
+	prevFacing.clear();
+	tweenTimer.clear();
+	prevTweenTimer.clear();
+	brains.clear();
+	brainRandom.clear();
+	sight.clear();
+
+	chaserCount = 0;
+	chaseTarget = NULL_ENTITY;
+	chaseFieldReady = false;
+}
+
+Entity CreateEntity(unsigned int x, unsigned int y, int entityFacing, EntityBrain brain)
+{
+	unsigned int index;
+
+	if (!freeSlots.empty())
+	{
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else if (slotGenerations.size() < MAX_ENTITIES)
+	{
+		index = (unsigned int)slotGenerations.size();
+		slotGenerations.push_back(0);
+		slotRows.push_back(0);
+	}
+	else
+	{
+		return NULL_ENTITY;
+	}
+
+	Entity entity = MAKE_ENTITY(index, slotGenerations[index]);
+	slotRows[index] = (unsigned int)rowEntities.size();
+
+	rowEntities.push_back(entity);
+	cellX.push_back(x);
+	cellY.push_back(y);
+	prevCellX.push_back(x);
+	prevCellY.push_back(y);
+	facing.push_back(entityFacing);
+	prevFacing.push_back(entityFacing);
+	tweenTimer.push_back(1.f);
+	prevTweenTimer.push_back(1.f);
+	brains.push_back((unsigned char)brain);
+
+	//Seed each brain from its handle so runs replay the same way, xorshift needs a non-zero state
+	brainRandom.push_back((entity * 2654435761u) | 1u);
+	sight.push_back(FieldOfView());
+
+	if (brain == ChaseBrain)
+	{
+		chaserCount++;
+	}
+
+	return entity;
+}
+
+bool IsEntityAlive(Entity entity)
+{
+	unsigned int index = ENTITY_INDEX(entity);
+	return entity != NULL_ENTITY && index < slotGenerations.size() && slotGenerations[index] == ENTITY_GENERATION(entity);
+}
+
+template <typename T>
+static void MoveRow(std::vector<T>& component, unsigned int from, unsigned int to)
+{
+	component[to] = component[from];
+	component.pop_back();
+}
+
+void DestroyEntity(Entity entity)
+{
+	if (!IsEntityAlive(entity))
+	{
+		return;
+	}
+
+	unsigned int index = ENTITY_INDEX(entity);
+	unsigned int row = slotRows[index];
+	unsigned int last = (unsigned int)rowEntities.size() - 1;
+
+	if (brains[row] == ChaseBrain)
+	{
+		chaserCount--;
+	}
+
+	//Fill the hole with the last row to keep the arrays packed
+	slotRows[ENTITY_INDEX(rowEntities[last])] = row;
+	MoveRow(rowEntities, last, row);
+	MoveRow(cellX, last, row);
+	MoveRow(cellY, last, row);
+	MoveRow(prevCellX, last, row);
+	MoveRow(prevCellY, last, row);
+	MoveRow(facing, last, row);
+	MoveRow(prevFacing, last, row);
+	MoveRow(tweenTimer, last, row);
+	MoveRow(prevTweenTimer, last, row);
+	MoveRow(brains, last, row);
+	MoveRow(brainRandom, last, row);
+	MoveRow(sight, last, row);
+
+	//Generations wrap within the bits left over above the index
+	slotGenerations[index] = (slotGenerations[index] + 1) & (0xFFFFFFFF >> ENTITY_INDEX_BITS);
+
+	//The last generation would make the null handle, retire the slot instead
+	if (MAKE_ENTITY(index, slotGenerations[index]) != NULL_ENTITY)
+	{
+		freeSlots.push_back(index);
+	}
+}
+
+unsigned int GetEntityCount()
+{
+	return (unsigned int)rowEntities.size();
+}
+
+static bool MoveRowEntity(unsigned int row, unsigned int direction)
+{
+	if (tweenTimer[row] < 1.f)
+	{
+		return false;
+	}
+
+	//Negative facings still land on the right direction since 2^32 is a multiple of 4
+	direction = (direction + (unsigned int)facing[row]) % 4;
+
+	unsigned int x = cellX[row];
+	unsigned int y = cellY[row];
+
+	switch (direction)
+	{
+	case 0: x++; break;
+	case 1: y++; break;
+	case 2: x--; break;
+	case 3: y--; break;
+	}
+
+	//Check for wall
+	if (!IsMapPath(x, y))
+	{
+		return false;
+	}
+
+	prevCellX[row] = cellX[row];
+	prevCellY[row] = cellY[row];
+	prevFacing[row] = facing[row];
+	cellX[row] = x;
+	cellY[row] = y;
+	tweenTimer[row] = 0.f;
+	prevTweenTimer[row] = 0.f;
+	return true;
+}
+
+static bool RotateRowEntity(unsigned int row, bool clockwise)
+{
+	if (tweenTimer[row] < 1.f)
+	{
+		return false;
+	}
+
+	prevCellX[row] = cellX[row];
+	prevCellY[row] = cellY[row];
+	prevFacing[row] = facing[row];
+	facing[row] += clockwise ? 1 : -1;
+	tweenTimer[row] = 0.f;
+	prevTweenTimer[row] = 0.f;
+	return true;
+}
+
+bool MoveEntity(Entity entity, unsigned int direction)
+{
+	return IsEntityAlive(entity) && MoveRowEntity(slotRows[ENTITY_INDEX(entity)], direction);
+}
+
+bool RotateEntity(Entity entity, bool clockwise)
+{
+	return IsEntityAlive(entity) && RotateRowEntity(slotRows[ENTITY_INDEX(entity)], clockwise);
+}
+
+ivec2 GetEntityCell(Entity entity)
+{
+	if (!IsEntityAlive(entity))
+	{
+		return ivec2(0);
+	}
+
+	unsigned int row = slotRows[ENTITY_INDEX(entity)];
+	return ivec2(cellX[row], cellY[row]);
+}
+
+int GetEntityFacing(Entity entity)
+{
+	return IsEntityAlive(entity) ? facing[slotRows[ENTITY_INDEX(entity)]] : 0;
+}
+
+void SetEntityChaseTarget(Entity target)
+{
+	chaseTarget = target;
+	chaseFieldReady = false;
+}
+
+static unsigned int NextBrainRandom(unsigned int row)
+{
+	unsigned int state = brainRandom[row];
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	brainRandom[row] = state;
+	return state;
+}
+
+//Each row only touches its own components, the map and flow field are read only here
+static void WanderRow(unsigned int row)
+{
+	//Mostly keep walking, sometimes turn
+	unsigned int roll = NextBrainRandom(row) % 8;
+
+	if (roll >= 6 || !MoveRowEntity(row, 0))
+	{
+		RotateRowEntity(row, roll % 2 == 0);
+	}
+}
+
+//Each row only touches its own components, the map and flow field are read only here
+static void TickEntityRows(unsigned int firstRow, unsigned int lastRow, float dt)
+{
+	for (unsigned int row = firstRow; row < lastRow; row++)
+	{
+		if (tweenTimer[row] < 1.f)
+		{
+			continue;
+		}
+
+		switch (brains[row])
+		{
+		case WanderBrain:
+			WanderRow(row);
+			break;
+		case ChaseBrain:
+			if (chaseFieldReady)
+			{
+				//Sight is only recomputed after the chaser has moved or turned
+				UpdateFieldOfView(sight[row], cellX[row], cellY[row], CHASE_SIGHT_RADIUS);
+
+				if (IsTileVisible(sight[row], chaseTargetCell.x, chaseTargetCell.y))
+				{
+					unsigned char direction = GetFlowDirection(chaseField, cellX[row], cellY[row]);
+
+					if (direction != FLOW_NO_DIRECTION)
+					{
+						//Flow directions are absolute, turn them into ones relative to facing
+						MoveRowEntity(row, (direction - (unsigned int)facing[row]) % 4);
+					}
+
+					break;
+				}
+			}
+
+			WanderRow(row);
+			break;
+		}
+	}
+
+	for (unsigned int row = firstRow; row < lastRow; row++)
+	{
+		prevTweenTimer[row] = tweenTimer[row];
+		tweenTimer[row] += dt * TWEEN_SPEED;
+	}
+}
+
+void TickEntities(float dt)
+{
+	PROFILE_SCOPE("Tick entities");
+
+	//Rebuild the shared field only when the target has moved
+	if (chaserCount > 0 && IsEntityAlive(chaseTarget))
+	{
+		ivec2 target = GetEntityCell(chaseTarget);
+		chaseTargetCell = target;
+
+		if (!chaseFieldReady || chaseField.goalX != (unsigned int)target.x || chaseField.goalY != (unsigned int)target.y
+			|| chaseField.width != GetMapWidth() || chaseField.height != GetMapHeight())
+		{
+			BuildFlowField(chaseField, target.x, target.y);
+			chaseFieldReady = true;
+		}
+	}
+	else
+	{
+		chaseFieldReady = false;
+	}
+
+	unsigned int rowCount = (unsigned int)rowEntities.size();
+
+	//Small counts aren't worth handing out as jobs
+	if (rowCount < PARALLEL_TICK_ENTITIES)
+	{
+		TickEntityRows(0, rowCount, dt);
+		return;
+	}
+
+	ParallelFor(0, rowCount, 1, [dt](unsigned int first, unsigned int last) { TickEntityRows(first, last, dt); });
+}
+
+static float RowTween(unsigned int row, float alpha)
+{
+	float timer = glm::min(glm::mix(prevTweenTimer[row], tweenTimer[row], alpha), 1.f);
+	return glm::smoothstep(0.f, 1.f, timer);
+}
+
+static vec3 RowRenderPosition(unsigned int row, float alpha)
+{
+	vec3 position((float)cellX[row], 0.f, (float)cellY[row]);
+	vec3 oldPosition((float)prevCellX[row], 0.f, (float)prevCellY[row]);
+	return glm::mix(oldPosition, position, RowTween(row, alpha));
+}
+
+vec3 GetEntityRenderPosition(Entity entity, float alpha)
+{
+	return IsEntityAlive(entity) ? RowRenderPosition(slotRows[ENTITY_INDEX(entity)], alpha) : vec3(0.f);
+}
+
+float GetEntityRenderRotation(Entity entity, float alpha)
+{
+	if (!IsEntityAlive(entity))
+	{
+		return 0.f;
+	}
+
+	unsigned int row = slotRows[ENTITY_INDEX(entity)];
+	return glm::mix(prevFacing[row] * 90.f, facing[row] * 90.f, RowTween(row, alpha));
+}
+
+void DrawEntities(float alpha, Entity skip, const FieldOfView* viewer)
+{
+	PROFILE_SCOPE("Draw entities");
+	PROFILE_GPU_SCOPE("Entities");
+
+	//Two crossed quads per entity, batched into one buffer each frame
+	const float quad[12][5] = {
+		{ -0.3f, -0.5f, 0.f, 0.f, 0.f }, { 0.3f, -0.5f, 0.f, 1.f, 0.f }, { 0.3f, 0.1f, 0.f, 1.f, 1.f },
+		{ -0.3f, -0.5f, 0.f, 0.f, 0.f }, { 0.3f, 0.1f, 0.f, 1.f, 1.f }, { -0.3f, 0.1f, 0.f, 0.f, 1.f },
+		{ 0.f, -0.5f, -0.3f, 0.f, 0.f }, { 0.f, -0.5f, 0.3f, 1.f, 0.f }, { 0.f, 0.1f, 0.3f, 1.f, 1.f },
+		{ 0.f, -0.5f, -0.3f, 0.f, 0.f }, { 0.f, 0.1f, 0.3f, 1.f, 1.f }, { 0.f, 0.1f, -0.3f, 0.f, 1.f }
+	};
+
+	std::vector<float> vertices;
+	vertices.reserve(rowEntities.size() * 12 * 5);
+
+	for (unsigned int row = 0; row < rowEntities.size(); row++)
+	{
+		if (rowEntities[row] == skip || (viewer != nullptr && !IsTileVisible(*viewer, cellX[row], cellY[row])))
+		{
+			continue;
+		}
+
+		vec3 position = RowRenderPosition(row, alpha);
+
+		for (int i = 0; i < 12; i++)
+		{
+			vertices.push_back(position.x + quad[i][0]);
+			vertices.push_back(position.y + quad[i][1]);
+			vertices.push_back(position.z + quad[i][2]);
+			vertices.push_back(quad[i][3]);
+			vertices.push_back(quad[i][4]);
+		}
+	}
+
+	if (vertices.empty())
+	{
+		return;
+	}
+
+	glUseProgram(entityShader);
+
+	glUniform4f(colorUniform, 1.0f, 0.3f, 0.3f, 1.0f);
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(textureUniform, 0);
+	glBindTexture(GL_TEXTURE_2D, entityTexture);
+
+	glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(mat4(1.0f)));
+	glUniformMatrix4fv(viewMatrixUniform, 1, GL_FALSE, glm::value_ptr(GetCameraView()));
+	glUniformMatrix4fv(projMatrixUniform, 1, GL_FALSE, glm::value_ptr(GetCameraProjection()));
+
+	glBindBuffer(GL_ARRAY_BUFFER, entityVBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//Entities aren't part of the baked lighting, the light attribute stays at full brightness
+	glVertexAttrib3f(2, 1.f, 1.f, 1.f);
+
+	glBindVertexArray(entityVAO);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / 5));
+	glBindVertexArray(0);
+}
\ No newline at end of file
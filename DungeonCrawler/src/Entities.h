@@ -0,0 +1,42 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "FieldOfView.h"
+
+//Handles pack a slot index in the low bits and the slot's generation above it,
+//so a handle to a destroyed entity never matches whatever reuses its slot
+typedef unsigned int Entity;
+
+#define ENTITY_INDEX_BITS 20
+#define MAX_ENTITIES (1u << ENTITY_INDEX_BITS)
+#define NULL_ENTITY 0xFFFFFFFF
+
+enum EntityBrain { NoBrain, WanderBrain, ChaseBrain };
+
+void InitializeEntities();
+void ClearEntities();
+
+Entity CreateEntity(unsigned int x, unsigned int y, int facing, EntityBrain brain);
+void DestroyEntity(Entity entity);
+bool IsEntityAlive(Entity entity);
+unsigned int GetEntityCount();
+
+//Facing is in quarter turns, directions are relative to it and use the MovePlayer convention.
+//Both fail while the entity is still tweening from its last action.
+bool MoveEntity(Entity entity, unsigned int direction);
+bool RotateEntity(Entity entity, bool clockwise);
+
+glm::ivec2 GetEntityCell(Entity entity);
+int GetEntityFacing(Entity entity);
+
+//Chasers walk a flow field towards this entity's cell while they can see it, and wander otherwise
+void SetEntityChaseTarget(Entity target);
+
+//Runs brains then tweens for every entity, large counts are split across threads
+void TickEntities(float dt);
+
+//Blends between the last two simulation steps like InterpolatePlayer
+glm::vec3 GetEntityRenderPosition(Entity entity, float alpha);
+float GetEntityRenderRotation(Entity entity, float alpha);
+//Only entities standing on tiles the viewer can see are drawn, a null viewer draws all of them
+void DrawEntities(float alpha, Entity skip, const FieldOfView* viewer);
\ No newline at end of file
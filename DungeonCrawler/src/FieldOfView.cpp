@@ -0,0 +1,219 @@
+#include <cstddef>
+#include "FieldOfView.h"
+#include "Map.h"
+
+//Maps each octant onto the first one, as (dx, dy) -> (x, y) multipliers
+static const int octantXX[8] = { 1, 0, 0, -1, -1, 0, 0, 1 };
+static const int octantXY[8] = { 0, 1, -1, 0, 0, -1, 1, 0 };
+static const int octantYX[8] = { 0, 1, 1, 0, 0, -1, -1, 0 };
+static const int octantYY[8] = { 1, 0, 0, 1, -1, 0, 0, -1 };
+
+static unsigned int exploredWidth;
+static unsigned int exploredHeight;
+static std::vector<unsigned long long> exploredBits;
+
+FieldOfView::FieldOfView()
+{
+	originX = 0;
+	originY = 0;
+	radius = 0;
+	mapVersion = 0;
+	version = 0;
+	rowWords = 0;
+}
+
+static void SetVisible(FieldOfView& view, int x, int y)
+{
+	//Window coordinates, the origin sits at (radius, radius)
+	int windowX = x - view.originX + (int)view.radius;
+	int windowY = y - view.originY + (int)view.radius;
+	view.visible[(size_t)windowY * view.rowWords + windowX / 64] |= 1ull << (windowX % 64);
+}
+
+//Scans one octant row by row, narrowing the lit slope range and recursing past each run of walls
+static void CastLight(FieldOfView& view, int octant, int row, float startSlope, float endSlope)
+{
+	if (startSlope < endSlope)
+	{
+		return;
+	}
+
+	int radius = (int)view.radius;
+	float nextStartSlope = startSlope;
+
+	for (int distance = row; distance <= radius; distance++)
+	{
+		bool blocked = false;
+		int dy = -distance;
+
+		for (int dx = -distance; dx <= 0; dx++)
+		{
+			float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+			float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+
+			if (startSlope < rightSlope)
+			{
+				continue;
+			}
+			else if (endSlope > leftSlope)
+			{
+				break;
+			}
+
+			int x = view.originX + dx * octantXX[octant] + dy * octantXY[octant];
+			int y = view.originY + dx * octantYX[octant] + dy * octantYY[octant];
+
+			if (dx * dx + dy * dy <= radius * radius)
+			{
+				SetVisible(view, x, y);
+			}
+
+			//Out of range coordinates wrap to huge values and read as walls
+			bool opaque = !IsMapPath(x, y);
+
+			if (blocked)
+			{
+				if (opaque)
+				{
+					nextStartSlope = rightSlope;
+				}
+				else
+				{
+					blocked = false;
+					startSlope = nextStartSlope;
+				}
+			}
+			else if (opaque && distance < radius)
+			{
+				blocked = true;
+				CastLight(view, octant, distance + 1, startSlope, leftSlope);
+				nextStartSlope = rightSlope;
+			}
+		}
+
+		if (blocked)
+		{
+			break;
+		}
+	}
+}
+
+void ComputeFieldOfView(FieldOfView& view, unsigned int x, unsigned int y, unsigned int radius)
+{
+	unsigned int windowSize = radius * 2 + 1;
+
+	view.originX = (int)x;
+	view.originY = (int)y;
+	view.radius = radius;
+	view.mapVersion = GetMapVersion();
+	view.rowWords = (windowSize + 63) / 64;
+	view.visible.assign((size_t)view.rowWords * windowSize, 0ull);
+	view.version++;
+
+	if (x >= GetMapWidth() || y >= GetMapHeight())
+	{
+		return;
+	}
+
+	SetVisible(view, x, y);
+
+	for (int octant = 0; octant < 8; octant++)
+	{
+		CastLight(view, octant, 1, 1.f, 0.f);
+	}
+}
+
+bool UpdateFieldOfView(FieldOfView& view, unsigned int x, unsigned int y, unsigned int radius)
+{
+	if (view.version != 0 && view.originX == (int)x && view.originY == (int)y && view.radius == radius && view.mapVersion == GetMapVersion())
+	{
+		return false;
+	}
+
+	ComputeFieldOfView(view, x, y, radius);
+	return true;
+}
+
+bool IsTileVisible(const FieldOfView& view, unsigned int x, unsigned int y)
+{
+	unsigned int windowX = x - view.originX + view.radius;
+	unsigned int windowY = y - view.originY + view.radius;
+
+	if (view.visible.empty() || windowX > view.radius * 2 || windowY > view.radius * 2)
+	{
+		return false;
+	}
+
+	return (view.visible[(size_t)windowY * view.rowWords + windowX / 64] >> (windowX % 64)) & 1ull;
+}
+
+void ResetExplored()
+{
+	exploredWidth = GetMapWidth();
+	exploredHeight = GetMapHeight();
+	exploredBits.assign((size_t)GetMapRowWords() * exploredHeight, 0ull);
+
+	//Every chunk has to drop the tiles that are now hidden
+	for (unsigned int y = 0; y < exploredHeight; y += MAP_CHUNK_SIZE)
+	{
+		for (unsigned int x = 0; x < exploredWidth; x += MAP_CHUNK_SIZE)
+		{
+			MarkMapTileDirty(x, y);
+		}
+	}
+}
+
+void MarkExplored(const FieldOfView& view)
+{
+	if (exploredWidth != GetMapWidth() || exploredHeight != GetMapHeight() || view.visible.empty())
+	{
+		return;
+	}
+
+	unsigned int windowSize = view.radius * 2 + 1;
+	unsigned int rowWords = GetMapRowWords();
+
+	for (unsigned int windowY = 0; windowY < windowSize; windowY++)
+	{
+		for (unsigned int windowX = 0; windowX < windowSize; windowX++)
+		{
+			if (!((view.visible[(size_t)windowY * view.rowWords + windowX / 64] >> (windowX % 64)) & 1ull))
+			{
+				continue;
+			}
+
+			unsigned int x = view.originX + windowX - view.radius;
+			unsigned int y = view.originY + windowY - view.radius;
+
+			if (x >= exploredWidth || y >= exploredHeight)
+			{
+				continue;
+			}
+
+			unsigned long long& word = exploredBits[(size_t)y * rowWords + x / 64];
+			unsigned long long bit = 1ull << (x % 64);
+
+			//Only newly seen tiles cost a chunk rebuild
+			if (!(word & bit))
+			{
+				word |= bit;
+				MarkMapTileDirty(x, y);
+			}
+		}
+	}
+}
+
+bool IsTileExplored(unsigned int x, unsigned int y)
+{
+	if (exploredWidth != GetMapWidth() || exploredHeight != GetMapHeight())
+	{
+		return true;
+	}
+
+	if (x >= exploredWidth || y >= exploredHeight)
+	{
+		return false;
+	}
+
+	return (exploredBits[(size_t)y * GetMapRowWords() + x / 64] >> (x % 64)) & 1ull;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+//Tiles seen from one cell, stored as a bitset over the square window around it
+//so computing and clearing it never touches the rest of the map
+struct FieldOfView
+{
+	int originX, originY;
+	unsigned int radius;
+	//Map edit count it was computed against
+	unsigned int mapVersion;
+	//Bumped on every recompute, lets renderers know when to re-upload
+	unsigned int version;
+	unsigned int rowWords;
+	std::vector<unsigned long long> visible;
+
+	FieldOfView();
+};
+
+//Recursive shadowcasting over the path grid in all directions, walls stop sight but are visible themselves
+void ComputeFieldOfView(FieldOfView& view, unsigned int x, unsigned int y, unsigned int radius);
+//Only recomputes when the cell or radius changed or the map was edited, returns true if it did
+bool UpdateFieldOfView(FieldOfView& view, unsigned int x, unsigned int y, unsigned int radius);
+bool IsTileVisible(const FieldOfView& view, unsigned int x, unsigned int y);
+
+//Fog of war, until ResetExplored is called for the current map every tile counts as explored
+void ResetExplored();
+void MarkExplored(const FieldOfView& view);
+bool IsTileExplored(unsigned int x, unsigned int y);
\ No newline at end of file
@@ -0,0 +1,349 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "LevelFile.h"
+#include "Map.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define LEVEL_FILE_VERSION 1
+
+//Layout: header, chunk table, path bits (row-major words), tile shapes (row-major bytes)
+struct LevelFileHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int width;
+	unsigned int height;
+	unsigned int chunkSize;
+	unsigned int chunkCount;
+	unsigned long long chunkTableOffset;
+	unsigned long long pathBitsOffset;
+	unsigned long long pathBitsSize;
+	unsigned long long shapesOffset;
+	unsigned long long shapesSize;
+};
+
+//Number of path tiles in each chunk, empty chunks don't need meshing
+struct LevelFileChunk
+{
+	unsigned int pathTileCount;
+};
+
+struct MappedFile
+{
+	const unsigned char* data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int file;
+#endif
+};
+
+static bool MapFile(const char* path, MappedFile& mapped)
+{
+	mapped.data = nullptr;
+	mapped.size = 0;
+
+#ifdef _WIN32
+	mapped.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (mapped.file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(mapped.file, &size);
+	mapped.size = (size_t)size.QuadPart;
+	mapped.mapping = mapped.size > 0 ? CreateFileMappingA(mapped.file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+
+	if (mapped.mapping == nullptr)
+	{
+		CloseHandle(mapped.file);
+		return false;
+	}
+
+	mapped.data = (const unsigned char*)MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0);
+
+	//The caller only unmaps files that mapped, so nothing is left open on failure
+	if (mapped.data == nullptr)
+	{
+		CloseHandle(mapped.mapping);
+		CloseHandle(mapped.file);
+	}
+#else
+	mapped.file = open(path, O_RDONLY);
+
+	if (mapped.file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	fstat(mapped.file, &info);
+	mapped.size = (size_t)info.st_size;
+
+	if (mapped.size > 0)
+	{
+		void* data = mmap(nullptr, mapped.size, PROT_READ, MAP_PRIVATE, mapped.file, 0);
+		mapped.data = data == MAP_FAILED ? nullptr : (const unsigned char*)data;
+	}
+
+	//The caller only unmaps files that mapped, so nothing is left open on failure
+	if (mapped.data == nullptr)
+	{
+		close(mapped.file);
+	}
+#endif
+
+	return mapped.data != nullptr;
+}
+
+//Written so a huge offset or size from a corrupt header can't wrap around past the end check
+static bool SectionInFile(unsigned long long offset, unsigned long long size, size_t fileSize)
+{
+	return offset <= fileSize && size <= fileSize - offset;
+}
+
+//Low nibble has to be a tile type and the rotation at most three quarter turns
+static bool ShapesValid(const unsigned char* shapes, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if ((shapes[i] & 0xF) > DeadEnd || (shapes[i] >> 4) > 3)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void UnmapFile(MappedFile& mapped)
+{
+#ifdef _WIN32
+	if (mapped.data)
+	{
+		UnmapViewOfFile(mapped.data);
+	}
+
+	CloseHandle(mapped.mapping);
+	CloseHandle(mapped.file);
+#else
+	if (mapped.data)
+	{
+		munmap((void*)mapped.data, mapped.size);
+	}
+
+	close(mapped.file);
+#endif
+}
+
+bool LoadLevelBinary(const char* path)
+{
+	MappedFile mapped;
+
+	if (!MapFile(path, mapped))
+	{
+		std::cout << "File read failed!\n";
+		return false;
+	}
+
+	LevelFileHeader header;
+	bool valid = mapped.size >= sizeof(header);
+
+	if (valid)
+	{
+		memcpy(&header, mapped.data, sizeof(header));
+
+		unsigned long long rowWords = (header.width + 63) / 64;
+		unsigned long long chunksX = (header.width + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+		unsigned long long chunksY = (header.height + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+
+		//Every section has to be exactly the size this map needs and sit inside the file
+		valid = memcmp(header.magic, "DCLV", 4) == 0
+			&& header.version == LEVEL_FILE_VERSION
+			&& header.chunkSize == MAP_CHUNK_SIZE
+			&& header.chunkCount == chunksX * chunksY
+			&& header.pathBitsSize == rowWords * header.height * sizeof(unsigned long long)
+			&& header.shapesSize == (unsigned long long)header.width * header.height
+			&& SectionInFile(header.chunkTableOffset, (unsigned long long)header.chunkCount * sizeof(LevelFileChunk), mapped.size)
+			&& SectionInFile(header.pathBitsOffset, header.pathBitsSize, mapped.size)
+			&& SectionInFile(header.shapesOffset, header.shapesSize, mapped.size)
+			&& ShapesValid(mapped.data + header.shapesOffset, (size_t)header.shapesSize);
+	}
+
+	if (!valid)
+	{
+		std::cout << "Level file '" << path << "' is invalid or from another version!\n";
+		UnmapFile(mapped);
+		return false;
+	}
+
+	ResizeMap(header.width, header.height);
+
+	if (header.width > 0 && header.height > 0)
+	{
+		//Sections share the map's memory layout, one copy each
+		memcpy(GetMapPathRow(0), mapped.data + header.pathBitsOffset, (size_t)header.pathBitsSize);
+		memcpy(GetMapShapeRow(0), mapped.data + header.shapesOffset, (size_t)header.shapesSize);
+
+		unsigned int chunksX = (header.width + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+		const unsigned char* chunkTable = mapped.data + header.chunkTableOffset;
+
+		for (unsigned int i = 0; i < header.chunkCount; i++)
+		{
+			LevelFileChunk chunk;
+			memcpy(&chunk, chunkTable + i * sizeof(LevelFileChunk), sizeof(chunk));
+
+			if (chunk.pathTileCount == 0)
+			{
+				MarkMapChunkEmpty(i % chunksX, i / chunksX);
+			}
+		}
+	}
+
+	UnmapFile(mapped);
+	return true;
+}
+
+bool SaveLevelBinary(const char* path)
+{
+	unsigned int width = GetMapWidth();
+	unsigned int height = GetMapHeight();
+	unsigned int chunksX = (width + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+	unsigned int chunksY = (height + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+
+	//Count path tiles per chunk for the chunk table
+	std::vector<LevelFileChunk> chunks(chunksX * chunksY, LevelFileChunk{ 0 });
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			if (IsMapPath(x, y))
+			{
+				chunks[(y / MAP_CHUNK_SIZE) * chunksX + x / MAP_CHUNK_SIZE].pathTileCount++;
+			}
+		}
+	}
+
+	LevelFileHeader header;
+	memcpy(header.magic, "DCLV", 4);
+	header.version = LEVEL_FILE_VERSION;
+	header.width = width;
+	header.height = height;
+	header.chunkSize = MAP_CHUNK_SIZE;
+	header.chunkCount = (unsigned int)chunks.size();
+	header.chunkTableOffset = sizeof(header);
+	header.pathBitsOffset = header.chunkTableOffset + chunks.size() * sizeof(LevelFileChunk);
+	header.pathBitsSize = (unsigned long long)GetMapRowWords() * height * sizeof(unsigned long long);
+	header.shapesOffset = header.pathBitsOffset + header.pathBitsSize;
+	header.shapesSize = (unsigned long long)width * height;
+
+	FILE* file = fopen(path, "wb");
+
+	if (file == nullptr)
+	{
+		std::cout << "File write failed!\n";
+		return false;
+	}
+
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(chunks.data(), sizeof(LevelFileChunk), chunks.size(), file);
+
+	if (width > 0 && height > 0)
+	{
+		fwrite(GetMapPathRow(0), 1, (size_t)header.pathBitsSize, file);
+		fwrite(GetMapShapeRow(0), 1, (size_t)header.shapesSize, file);
+	}
+
+	bool success = ferror(file) == 0;
+	fclose(file);
+	return success;
+}
+
+bool ImportLevelText(const char* path)
+{
+	//Slurp the whole file in one read
+	FILE* file = fopen(path, "rb");
+
+	if (file == nullptr)
+	{
+		std::cout << "File read failed!\n";
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	std::vector<char> data(size > 0 ? size : 0);
+	size_t readSize = fread(data.data(), 1, data.size(), file);
+	fclose(file);
+
+	if (readSize != data.size())
+	{
+		std::cout << "File read failed!\n";
+		return false;
+	}
+
+	const char* begin = data.data();
+	const char* end = begin + data.size();
+
+	//First pass measures the level with memchr jumping from newline to newline
+	unsigned int width = 0;
+	unsigned int height = 0;
+
+	for (const char* line = begin; line < end; height++)
+	{
+		const char* newline = (const char*)memchr(line, '\n', end - line);
+		const char* lineEnd = newline ? newline : end;
+
+		if (lineEnd > line && lineEnd[-1] == '\r')
+		{
+			lineEnd--;
+		}
+
+		width = std::max(width, (unsigned int)(lineEnd - line));
+		line = newline ? newline + 1 : end;
+	}
+
+	ResizeMap(width, height);
+
+	//Second pass only visits the '*' characters in each row
+	const char* line = begin;
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const char* newline = (const char*)memchr(line, '\n', end - line);
+		const char* lineEnd = newline ? newline : end;
+		unsigned long long* row = GetMapPathRow(y);
+
+		for (const char* c = line; (c = (const char*)memchr(c, '*', lineEnd - c)) != nullptr; c++)
+		{
+			unsigned int x = (unsigned int)(c - line);
+			row[x / 64] |= 1ull << (x % 64);
+		}
+
+		line = newline ? newline + 1 : end;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+//Binary levels store the path bits and precomputed tile shapes exactly as the map holds them,
+//so loading is a memory map and a couple of copies instead of parsing and classifying
+bool LoadLevelBinary(const char* path);
+bool SaveLevelBinary(const char* path);
+
+//Reads the ASCII level format, each line is a row and '*' marks a path tile
+bool ImportLevelText(const char* path);
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "glm/glm.hpp"
+#include "LevelGenerator.h"
+#include "Map.h"
+
+using glm::ivec2;
+
+//Rooms and corridors places one room per grid cell of this size
+#define ROOM_CELL_SIZE 24
+//Binary space partition stops splitting below twice this size
+#define BSP_LEAF_SIZE 8
+#define CAVE_ITERATIONS 4
+
+//Sets the path bits of a rectangle (max exclusive), clipped so the outer ring stays solid
+static void CarveRect(int minX, int minY, int maxX, int maxY)
+{
+	minX = std::max(minX, 1);
+	minY = std::max(minY, 1);
+	maxX = std::min(maxX, (int)GetMapWidth() - 1);
+	maxY = std::min(maxY, (int)GetMapHeight() - 1);
+
+	if (minX >= maxX || minY >= maxY)
+	{
+		return;
+	}
+
+	for (int y = minY; y < maxY; y++)
+	{
+		unsigned long long* row = GetMapPathRow(y);
+
+		//Whole words at a time, only the first and last word are partial
+		for (int w = minX / 64; w <= (maxX - 1) / 64; w++)
+		{
+			int first = std::max(minX, w * 64) - w * 64;
+			int count = std::min(maxX, w * 64 + 64) - w * 64 - first;
+			unsigned long long bits = count == 64 ? ~0ull : ((1ull << count) - 1);
+
+			row[w] |= bits << first;
+		}
+	}
+}
+
+//L shaped corridor between two points
+static void CarveCorridor(ivec2 a, ivec2 b, bool horizontalFirst)
+{
+	ivec2 corner = horizontalFirst ? ivec2(b.x, a.y) : ivec2(a.x, b.y);
+
+	CarveRect(std::min(a.x, corner.x), std::min(a.y, corner.y), std::max(a.x, corner.x) + 1, std::max(a.y, corner.y) + 1);
+	CarveRect(std::min(b.x, corner.x), std::min(b.y, corner.y), std::max(b.x, corner.x) + 1, std::max(b.y, corner.y) + 1);
+}
+
+//Random sized room somewhere inside the area (max exclusive), returns its center
+static ivec2 CarveRoom(std::mt19937& random, int minX, int minY, int maxX, int maxY)
+{
+	int areaWidth = maxX - minX;
+	int areaHeight = maxY - minY;
+
+	if (areaWidth < 5 || areaHeight < 5)
+	{
+		return ivec2((minX + maxX) / 2, (minY + maxY) / 2);
+	}
+
+	//Leave at least a tile of wall on each side
+	int roomWidth = 3 + random() % (areaWidth - 4);
+	int roomHeight = 3 + random() % (areaHeight - 4);
+	int x = minX + 1 + random() % (areaWidth - roomWidth - 1);
+	int y = minY + 1 + random() % (areaHeight - roomHeight - 1);
+
+	CarveRect(x, y, x + roomWidth, y + roomHeight);
+	return ivec2(x + roomWidth / 2, y + roomHeight / 2);
+}
+
+static void GenerateRoomsAndCorridors(std::mt19937& random, unsigned int width, unsigned int height)
+{
+	//A room per cell keeps generation linear in map area
+	int cellsX = std::max(1, (int)width / ROOM_CELL_SIZE);
+	int cellsY = std::max(1, (int)height / ROOM_CELL_SIZE);
+	std::vector<ivec2> centers(cellsX * cellsY);
+
+	for (int cy = 0; cy < cellsY; cy++)
+	{
+		for (int cx = 0; cx < cellsX; cx++)
+		{
+			centers[cy * cellsX + cx] = CarveRoom(random, cx * width / cellsX, cy * height / cellsY, (cx + 1) * width / cellsX, (cy + 1) * height / cellsY);
+		}
+	}
+
+	for (int cy = 0; cy < cellsY; cy++)
+	{
+		//Every row is joined up, and at least one corridor leads to the next row
+		int link = random() % cellsX;
+
+		for (int cx = 0; cx < cellsX; cx++)
+		{
+			ivec2 center = centers[cy * cellsX + cx];
+
+			if (cx + 1 < cellsX)
+			{
+				CarveCorridor(center, centers[cy * cellsX + cx + 1], random() % 2 == 0);
+			}
+
+			if (cy + 1 < cellsY && (cx == link || random() % 3 == 0))
+			{
+				CarveCorridor(center, centers[(cy + 1) * cellsX + cx], random() % 2 == 0);
+			}
+		}
+	}
+}
+
+//Splits along the longer side until areas are small, then joins each pair of halves with a corridor
+static ivec2 GenerateBinarySpacePartition(std::mt19937& random, int minX, int minY, int maxX, int maxY)
+{
+	int areaWidth = maxX - minX;
+	int areaHeight = maxY - minY;
+
+	if (areaWidth < BSP_LEAF_SIZE * 2 && areaHeight < BSP_LEAF_SIZE * 2)
+	{
+		return CarveRoom(random, minX, minY, maxX, maxY);
+	}
+
+	ivec2 a, b;
+
+	if (areaWidth >= areaHeight)
+	{
+		int split = minX + BSP_LEAF_SIZE + random() % (areaWidth - BSP_LEAF_SIZE * 2 + 1);
+		a = GenerateBinarySpacePartition(random, minX, minY, split, maxY);
+		b = GenerateBinarySpacePartition(random, split, minY, maxX, maxY);
+	}
+	else
+	{
+		int split = minY + BSP_LEAF_SIZE + random() % (areaHeight - BSP_LEAF_SIZE * 2 + 1);
+		a = GenerateBinarySpacePartition(random, minX, minY, maxX, split);
+		b = GenerateBinarySpacePartition(random, minX, split, maxX, maxY);
+	}
+
+	CarveCorridor(a, b, random() % 2 == 0);
+	return random() % 2 == 0 ? a : b;
+}
+
+//Adds one bit-plane to a 4 bit counter held in four words, 64 counters at once
+static void AddToCount(unsigned long long bits, unsigned long long count[4])
+{
+	unsigned long long carry0 = count[0] & bits;
+	count[0] ^= bits;
+	unsigned long long carry1 = count[1] & carry0;
+	count[1] ^= carry0;
+	unsigned long long carry2 = count[2] & carry1;
+	count[2] ^= carry1;
+	count[3] |= carry2;
+}
+
+static void GenerateCaves(std::mt19937& random, unsigned int width, unsigned int height)
+{
+	unsigned int rowWords = GetMapRowWords();
+	unsigned long long lastWordMask = width % 64 == 0 ? ~0ull : (1ull << (width % 64)) - 1;
+	std::mt19937_64 bitRandom(random());
+
+	//Work on wall bits, everything outside the map counts as wall
+	std::vector<unsigned long long> walls((size_t)rowWords * height);
+	std::vector<unsigned long long> nextWalls((size_t)rowWords * height);
+	std::vector<unsigned long long> solidRow(rowWords, ~0ull);
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		unsigned long long* row = &walls[(size_t)y * rowWords];
+
+		for (unsigned int w = 0; w < rowWords; w++)
+		{
+			//Roughly 56% floor to start with
+			unsigned long long floor = bitRandom() | (bitRandom() & bitRandom() & bitRandom());
+			row[w] = ~floor;
+		}
+
+		row[0] |= 1ull;
+		row[rowWords - 1] |= ~lastWordMask | (1ull << ((width - 1) % 64));
+	}
+
+	std::fill(walls.begin(), walls.begin() + rowWords, ~0ull);
+	std::fill(walls.end() - rowWords, walls.end(), ~0ull);
+
+	for (int iteration = 0; iteration < CAVE_ITERATIONS; iteration++)
+	{
+		for (unsigned int y = 0; y < height; y++)
+		{
+			const unsigned long long* rows[3] = {
+				y > 0 ? &walls[(size_t)(y - 1) * rowWords] : solidRow.data(),
+				&walls[(size_t)y * rowWords],
+				y + 1 < height ? &walls[(size_t)(y + 1) * rowWords] : solidRow.data()
+			};
+
+			unsigned long long* out = &nextWalls[(size_t)y * rowWords];
+
+			for (unsigned int w = 0; w < rowWords; w++)
+			{
+				//Count walls in the 3x3 block around every tile of the word
+				unsigned long long count[4] = { 0, 0, 0, 0 };
+
+				for (int r = 0; r < 3; r++)
+				{
+					unsigned long long center = rows[r][w];
+					unsigned long long east = (center >> 1) | (w + 1 < rowWords ? rows[r][w + 1] << 63 : 1ull << 63);
+					unsigned long long west = (center << 1) | (w > 0 ? rows[r][w - 1] >> 63 : 1ull);
+
+					AddToCount(center, count);
+					AddToCount(east, count);
+					AddToCount(west, count);
+				}
+
+				//Wall where at least 5 of the 9 are walls
+				out[w] = count[3] | (count[2] & (count[1] | count[0]));
+			}
+
+			out[0] |= 1ull;
+			out[rowWords - 1] |= ~lastWordMask | (1ull << ((width - 1) % 64));
+		}
+
+		std::fill(nextWalls.begin(), nextWalls.begin() + rowWords, ~0ull);
+		std::fill(nextWalls.end() - rowWords, nextWalls.end(), ~0ull);
+		walls.swap(nextWalls);
+	}
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		unsigned long long* row = GetMapPathRow(y);
+
+		for (unsigned int w = 0; w < rowWords; w++)
+		{
+			row[w] = ~walls[(size_t)y * rowWords + w];
+		}
+
+		row[rowWords - 1] &= lastWordMask;
+	}
+}
+
+//Recursive backtracker on the odd coordinates, with a few extra walls knocked out so there are loops
+static void GenerateMaze(std::mt19937& random, unsigned int width, unsigned int height)
+{
+	const int stepX[4] = { 2, 0, -2, 0 };
+	const int stepY[4] = { 0, 2, 0, -2 };
+
+	std::vector<ivec2> stack;
+	stack.push_back(ivec2(1, 1));
+	CarveRect(1, 1, 2, 2);
+
+	while (!stack.empty())
+	{
+		ivec2 cell = stack.back();
+		int options[4];
+		int optionCount = 0;
+
+		for (int direction = 0; direction < 4; direction++)
+		{
+			int nx = cell.x + stepX[direction];
+			int ny = cell.y + stepY[direction];
+
+			if (nx > 0 && ny > 0 && nx < (int)width - 1 && ny < (int)height - 1 && !IsMapPath(nx, ny))
+			{
+				options[optionCount++] = direction;
+			}
+		}
+
+		if (optionCount == 0)
+		{
+			stack.pop_back();
+			continue;
+		}
+
+		int direction = options[random() % optionCount];
+		ivec2 next(cell.x + stepX[direction], cell.y + stepY[direction]);
+
+		CarveRect(std::min(cell.x, next.x), std::min(cell.y, next.y), std::max(cell.x, next.x) + 1, std::max(cell.y, next.y) + 1);
+		stack.push_back(next);
+	}
+
+	for (unsigned int i = 0; i < width * height / 50; i++)
+	{
+		int x = 1 + random() % (width - 2);
+		int y = 1 + random() % (height - 2);
+		CarveRect(x, y, x + 1, y + 1);
+	}
+}
+
+void GenerateLevelPaths(LevelLayout layout, unsigned int width, unsigned int height, unsigned int seed)
+{
+	ResizeMap(width, height);
+
+	//Nothing fits inside the solid outer ring
+	if (width < 3 || height < 3)
+	{
+		return;
+	}
+
+	std::mt19937 random(seed);
+
+	switch (layout)
+	{
+	case RoomsAndCorridors:
+		GenerateRoomsAndCorridors(random, width, height);
+		break;
+	case BinarySpacePartition:
+		GenerateBinarySpacePartition(random, 0, 0, width, height);
+		break;
+	case Caves:
+		GenerateCaves(random, width, height);
+		break;
+	case Maze:
+		GenerateMaze(random, width, height);
+		break;
+	}
+}
+
+void GenerateLevel(LevelLayout layout, unsigned int width, unsigned int height, unsigned int seed)
+{
+	GenerateLevelPaths(layout, width, height, seed);
+	ClassifyMap();
+}
\ No newline at end of file
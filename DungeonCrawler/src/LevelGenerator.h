@@ -0,0 +1,8 @@
+#pragma once
+
+enum LevelLayout { RoomsAndCorridors, BinarySpacePartition, Caves, Maze };
+
+//Fills the map with a seeded random level, the outer ring of tiles is always solid.
+//GenerateLevelPaths only sets the path bits, GenerateLevel also classifies like LoadLevel does.
+void GenerateLevelPaths(LevelLayout layout, unsigned int width, unsigned int height, unsigned int seed);
+void GenerateLevel(LevelLayout layout, unsigned int width, unsigned int height, unsigned int seed);
\ No newline at end of file
@@ -0,0 +1,382 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "Lighting.h"
+#include "Map.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+using glm::vec2;
+using glm::vec3;
+
+//Bumped whenever the bake changes, so old cache files stop matching
+#define LIGHTING_VERSION 1
+#define LIGHT_CACHE_DIRECTORY "levels/"
+
+//Maps with at least this many tiles are baked on multiple threads
+#define PARALLEL_BAKE_TILES (256 * 256)
+
+#define AO_RAY_COUNT 16
+#define AO_RADIUS 3.f
+#define AO_STRENGTH 0.6f
+#define AMBIENT_LIGHT 0.5f
+
+//Roughly one in TORCH_RARITY tiles next to a wall gets a torch
+#define TORCH_RARITY 24
+#define TORCH_RADIUS 6.f
+
+static const vec3 torchColor(1.f, 0.75f, 0.45f);
+
+struct LightCacheHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int width;
+	unsigned int height;
+	unsigned long long levelHash;
+};
+
+static unsigned int lightWidth;
+static unsigned int lightHeight;
+//RGB bytes for each of the (width + 1) * (height + 1) corners
+static std::vector<unsigned char> cornerLight;
+
+//Torches binned by map chunk so a corner only looks at the ones nearby
+static unsigned int torchChunksX;
+static unsigned int torchChunksY;
+static std::vector<std::vector<vec2>> torchChunks;
+
+static vec2 aoDirections[AO_RAY_COUNT];
+
+unsigned long long HashLevel()
+{
+	//FNV-1a over the size and path words
+	unsigned long long hash = 14695981039346656037ull;
+	unsigned long long values[3] = { GetMapWidth(), GetMapHeight(), LIGHTING_VERSION };
+
+	for (unsigned long long value : values)
+	{
+		hash = (hash ^ value) * 1099511628211ull;
+	}
+
+	for (unsigned int y = 0; y < GetMapHeight(); y++)
+	{
+		const unsigned long long* row = GetMapPathRow(y);
+
+		for (unsigned int w = 0; w < GetMapRowWords(); w++)
+		{
+			hash = (hash ^ row[w]) * 1099511628211ull;
+		}
+	}
+
+	return hash;
+}
+
+//Distance along a ray until it enters a wall tile, capped at maxDistance
+static float TraceRay(vec2 origin, vec2 direction, float maxDistance)
+{
+	//Shift so tile cells span whole numbers
+	vec2 start = origin + vec2(0.5f) + direction * 0.001f;
+	int cellX = (int)std::floor(start.x);
+	int cellY = (int)std::floor(start.y);
+
+	int stepX = direction.x > 0.f ? 1 : -1;
+	int stepY = direction.y > 0.f ? 1 : -1;
+	float deltaX = direction.x != 0.f ? std::abs(1.f / direction.x) : INFINITY;
+	float deltaY = direction.y != 0.f ? std::abs(1.f / direction.y) : INFINITY;
+	float nextX = direction.x != 0.f ? (direction.x > 0.f ? cellX + 1 - start.x : start.x - cellX) * deltaX : INFINITY;
+	float nextY = direction.y != 0.f ? (direction.y > 0.f ? cellY + 1 - start.y : start.y - cellY) * deltaY : INFINITY;
+	float distance = 0.f;
+
+	while (distance < maxDistance)
+	{
+		//Negative cells wrap to huge coordinates and read as walls
+		if (!IsMapPath(cellX, cellY))
+		{
+			return distance;
+		}
+
+		if (nextX < nextY)
+		{
+			distance = nextX;
+			nextX += deltaX;
+			cellX += stepX;
+		}
+		else
+		{
+			distance = nextY;
+			nextY += deltaY;
+			cellY += stepY;
+		}
+	}
+
+	return maxDistance;
+}
+
+static bool HasTorch(unsigned int x, unsigned int y)
+{
+	if (!IsMapPath(x, y) || GetMapTile(x, y).type == Open)
+	{
+		return false;
+	}
+
+	//Integer hash of the tile so placement only depends on the level
+	unsigned int hash = x * 73856093u ^ y * 19349663u;
+	hash ^= hash >> 13;
+	hash *= 0x5bd1e995u;
+	hash ^= hash >> 15;
+	return hash % TORCH_RARITY == 0;
+}
+
+static void GatherTorches(unsigned int chunkX, unsigned int chunkY)
+{
+	std::vector<vec2>& torches = torchChunks[(size_t)chunkY * torchChunksX + chunkX];
+	unsigned int lastX = std::min((chunkX + 1) * MAP_CHUNK_SIZE, GetMapWidth());
+	unsigned int lastY = std::min((chunkY + 1) * MAP_CHUNK_SIZE, GetMapHeight());
+
+	torches.clear();
+
+	for (unsigned int y = chunkY * MAP_CHUNK_SIZE; y < lastY; y++)
+	{
+		for (unsigned int x = chunkX * MAP_CHUNK_SIZE; x < lastX; x++)
+		{
+			if (HasTorch(x, y))
+			{
+				torches.push_back(vec2((float)x, (float)y));
+			}
+		}
+	}
+}
+
+static void BakeCorner(unsigned int x, unsigned int y)
+{
+	unsigned char* out = &cornerLight[((size_t)y * (lightWidth + 1) + x) * 3];
+
+	//Corners with no path tile around them are never drawn
+	if (!IsMapPath(x, y) && !IsMapPath(x - 1, y) && !IsMapPath(x, y - 1) && !IsMapPath(x - 1, y - 1))
+	{
+		out[0] = out[1] = out[2] = 0;
+		return;
+	}
+
+	vec2 position(x - 0.5f, y - 0.5f);
+
+	//Walls are infinitely tall, so occlusion only depends on the horizontal plane
+	float occlusion = 0.f;
+
+	for (int i = 0; i < AO_RAY_COUNT; i++)
+	{
+		occlusion += 1.f - TraceRay(position, aoDirections[i], AO_RADIUS) / AO_RADIUS;
+	}
+
+	vec3 light(AMBIENT_LIGHT * (1.f - AO_STRENGTH * occlusion / AO_RAY_COUNT));
+
+	int minChunkX = std::max((int)std::floor((position.x - TORCH_RADIUS) / MAP_CHUNK_SIZE), 0);
+	int minChunkY = std::max((int)std::floor((position.y - TORCH_RADIUS) / MAP_CHUNK_SIZE), 0);
+	int maxChunkX = std::min((int)std::floor((position.x + TORCH_RADIUS) / MAP_CHUNK_SIZE), (int)torchChunksX - 1);
+	int maxChunkY = std::min((int)std::floor((position.y + TORCH_RADIUS) / MAP_CHUNK_SIZE), (int)torchChunksY - 1);
+
+	for (int chunkY = minChunkY; chunkY <= maxChunkY; chunkY++)
+	{
+		for (int chunkX = minChunkX; chunkX <= maxChunkX; chunkX++)
+		{
+			for (const vec2& torch : torchChunks[(size_t)chunkY * torchChunksX + chunkX])
+			{
+				vec2 offset = position - torch;
+				float distance = glm::length(offset);
+
+				//Shadow ray from the torch, stopping just short of the corner it lands on
+				if (distance >= TORCH_RADIUS || TraceRay(torch, offset / distance, distance - 0.01f) < distance - 0.01f)
+				{
+					continue;
+				}
+
+				float falloff = 1.f - distance / TORCH_RADIUS;
+				light += torchColor * falloff * falloff;
+			}
+		}
+	}
+
+	light = glm::min(light, vec3(1.f));
+	out[0] = (unsigned char)(light.r * 255.f + 0.5f);
+	out[1] = (unsigned char)(light.g * 255.f + 0.5f);
+	out[2] = (unsigned char)(light.b * 255.f + 0.5f);
+}
+
+static void BakeCornerRows(unsigned int firstRow, unsigned int lastRow)
+{
+	for (unsigned int y = firstRow; y < lastRow; y++)
+	{
+		for (unsigned int x = 0; x <= lightWidth; x++)
+		{
+			BakeCorner(x, y);
+		}
+	}
+}
+
+//Sizes the corner grid and finds every torch, everything a bake or a cached load needs first
+static void PrepareLighting()
+{
+	for (int i = 0; i < AO_RAY_COUNT; i++)
+	{
+		float angle = (i + 0.5f) * 6.2831853f / AO_RAY_COUNT;
+		aoDirections[i] = vec2(std::cos(angle), std::sin(angle));
+	}
+
+	lightWidth = GetMapWidth();
+	lightHeight = GetMapHeight();
+	cornerLight.assign((size_t)(lightWidth + 1) * (lightHeight + 1) * 3, 0);
+
+	torchChunksX = (lightWidth + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+	torchChunksY = (lightHeight + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+	torchChunks.assign((size_t)torchChunksX * torchChunksY, std::vector<vec2>());
+
+	for (unsigned int chunkY = 0; chunkY < torchChunksY; chunkY++)
+	{
+		for (unsigned int chunkX = 0; chunkX < torchChunksX; chunkX++)
+		{
+			GatherTorches(chunkX, chunkY);
+		}
+	}
+}
+
+void BakeLighting()
+{
+	PROFILE_SCOPE("Bake lighting");
+	PrepareLighting();
+
+	unsigned int rowCount = lightHeight + 1;
+
+	//Small maps aren't worth handing out as jobs
+	if ((size_t)lightWidth * lightHeight < PARALLEL_BAKE_TILES)
+	{
+		BakeCornerRows(0, rowCount);
+		return;
+	}
+
+	//Each job writes its own band of corner rows, the map and torches are read only
+	ParallelFor(0, rowCount, 1, BakeCornerRows);
+}
+
+static void GetCachePath(char* path, size_t size, unsigned long long hash)
+{
+	snprintf(path, size, "%s%016llx.light", LIGHT_CACHE_DIRECTORY, hash);
+}
+
+void LoadOrBakeLighting()
+{
+	unsigned long long hash = HashLevel();
+	char path[256];
+	GetCachePath(path, sizeof(path), hash);
+
+	FILE* file = fopen(path, "rb");
+
+	if (file != nullptr)
+	{
+		LightCacheHeader header;
+		size_t cornerBytes = (size_t)(GetMapWidth() + 1) * (GetMapHeight() + 1) * 3;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "DCLT", 4) == 0
+			&& header.version == LIGHTING_VERSION && header.width == GetMapWidth() && header.height == GetMapHeight() && header.levelHash == hash;
+
+		if (valid)
+		{
+			//Torches are cheap to find again and RelightTile needs them
+			PrepareLighting();
+
+			if (fread(cornerLight.data(), 1, cornerBytes, file) == cornerBytes)
+			{
+				fclose(file);
+				return;
+			}
+		}
+
+		fclose(file);
+	}
+
+	BakeLighting();
+
+	file = fopen(path, "wb");
+
+	if (file == nullptr)
+	{
+		std::cout << "Lighting cache write failed!\n";
+		return;
+	}
+
+	LightCacheHeader header = { { 'D', 'C', 'L', 'T' }, LIGHTING_VERSION, lightWidth, lightHeight, hash };
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(cornerLight.data(), 1, cornerLight.size(), file);
+	fclose(file);
+}
+
+void ClearLighting()
+{
+	lightWidth = 0;
+	lightHeight = 0;
+	cornerLight.clear();
+	torchChunks.clear();
+	torchChunksX = 0;
+	torchChunksY = 0;
+}
+
+bool IsLightingBaked()
+{
+	return !cornerLight.empty() && lightWidth == GetMapWidth() && lightHeight == GetMapHeight();
+}
+
+void RelightTile(unsigned int x, unsigned int y)
+{
+	if (!IsLightingBaked())
+	{
+		return;
+	}
+
+	//The tile and its neighbors may have gained or lost a torch
+	for (unsigned int chunkY = (y > 0 ? y - 1 : 0) / MAP_CHUNK_SIZE; chunkY <= std::min(y + 1, lightHeight - 1) / MAP_CHUNK_SIZE; chunkY++)
+	{
+		for (unsigned int chunkX = (x > 0 ? x - 1 : 0) / MAP_CHUNK_SIZE; chunkX <= std::min(x + 1, lightWidth - 1) / MAP_CHUNK_SIZE; chunkX++)
+		{
+			GatherTorches(chunkX, chunkY);
+		}
+	}
+
+	//Torches and AO both reach this far, plus a tile for the torches next door
+	int reach = (int)std::ceil(std::max(TORCH_RADIUS, AO_RADIUS)) + 2;
+	int minX = std::max((int)x - reach, 0);
+	int minY = std::max((int)y - reach, 0);
+	int maxX = std::min((int)x + reach, (int)lightWidth);
+	int maxY = std::min((int)y + reach, (int)lightHeight);
+
+	for (int cornerY = minY; cornerY <= maxY; cornerY++)
+	{
+		for (int cornerX = minX; cornerX <= maxX; cornerX++)
+		{
+			BakeCorner(cornerX, cornerY);
+		}
+	}
+
+	//Corners touch the tiles on both sides of them
+	for (int chunkY = std::max(minY - 1, 0) / MAP_CHUNK_SIZE; chunkY <= maxY / MAP_CHUNK_SIZE; chunkY++)
+	{
+		for (int chunkX = std::max(minX - 1, 0) / MAP_CHUNK_SIZE; chunkX <= maxX / MAP_CHUNK_SIZE; chunkX++)
+		{
+			MarkMapTileDirty(chunkX * MAP_CHUNK_SIZE, chunkY * MAP_CHUNK_SIZE);
+		}
+	}
+}
+
+vec3 GetCornerLight(unsigned int x, unsigned int y)
+{
+	if (!IsLightingBaked() || x > lightWidth || y > lightHeight)
+	{
+		return vec3(1.f);
+	}
+
+	const unsigned char* light = &cornerLight[((size_t)y * (lightWidth + 1) + x) * 3];
+	return vec3(light[0], light[1], light[2]) / 255.f;
+}
\ No newline at end of file
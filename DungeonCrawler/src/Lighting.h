@@ -0,0 +1,19 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+//Static light baked at the corners of every tile, corner (x, y) sits at world (x - 0.5, y - 0.5).
+//Every tile vertex lands on a corner, so chunk meshes pick their vertex colors straight from here.
+void BakeLighting();
+//Reuses a bake of an identical level from disk if there is one, bakes and saves it otherwise
+void LoadOrBakeLighting();
+void ClearLighting();
+bool IsLightingBaked();
+
+//Rebakes the corners a single tile edit can affect and marks their chunks dirty
+void RelightTile(unsigned int x, unsigned int y);
+
+glm::vec3 GetCornerLight(unsigned int x, unsigned int y);
+
+//Identifies a level by its size and path bits
+unsigned long long HashLevel();
\ No newline at end of file
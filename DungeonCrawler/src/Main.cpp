@@ -2,10 +2,18 @@
 #include <glad.h>
 #include <glfw3.h>
 #include <vector>
+#include <cstring>
+#include <random>
 #include "Shader.h"
 #include "Camera.h"
 #include "Map.h"
 #include "Player.h"
+#include "Entities.h"
+#include "FieldOfView.h"
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Headless.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -17,6 +25,16 @@
 #define WINDOW_WIDTH 1024
 #define WINDOW_HEIGHT 768
 
+//Game logic runs at this many steps per second no matter how fast frames are drawn
+#define SIMULATION_RATE 30.0
+//Longest frame the simulation will try to catch up on, anything more is dropped
+#define MAX_FRAME_TIME 0.25
+
+#define MONSTER_COUNT 16
+
+//Written in the working directory when the trace key is pressed
+#define PROFILER_TRACE_PATH "profile.json"
+
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
@@ -30,6 +48,17 @@ void ProcessInput(GLFWwindow* window, float dt)
 		glfwSetWindowShouldClose(window, true);
 	}
 
+	//Dump the profiler's last few seconds once per press
+	static bool tracePressed = false;
+	bool traceKey = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+
+	if (traceKey && !tracePressed)
+	{
+		WriteProfilerTrace(PROFILER_TRACE_PATH);
+	}
+
+	tracePressed = traceKey;
+
 	//Player controls
 	//Forward/Back
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
@@ -122,52 +151,132 @@ void MouseScrollCallback(GLFWwindow* window, double scrollX, double scrollY)
 	SetCameraFOV(GetCameraFOV() - (float)scrollY);
 }
 
-int main()
+//Drops monsters on random path tiles, half wander and half chase the player
+void SpawnMonsters(unsigned int count, unsigned int seed)
 {
-	//Initialize GLFW and create window
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	std::vector<glm::ivec2> pathTiles;
 
-	GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Dungeon Crawler", nullptr, nullptr);
+	for (unsigned int y = 0; y < GetMapHeight(); y++)
+	{
+		for (unsigned int x = 0; x < GetMapWidth(); x++)
+		{
+			if (IsMapPath(x, y))
+			{
+				pathTiles.push_back(glm::ivec2(x, y));
+			}
+		}
+	}
 
-	if (window == nullptr)
+	if (pathTiles.empty())
 	{
-		std::cout << "Failed to create GLFW window\n";
-		glfwTerminate();
-		return -1;
+		return;
 	}
 
-	glfwMakeContextCurrent(window);
+	std::mt19937 random(seed);
 
-	//Initialize GLAD
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	for (unsigned int i = 0; i < count; i++)
 	{
-		std::cout << "Failed to initialize GLAD\n";
-		return -1;
+		glm::ivec2 tile = pathTiles[random() % pathTiles.size()];
+		CreateEntity(tile.x, tile.y, random() % 4, i % 2 == 0 ? WanderBrain : ChaseBrain);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	//Worker threads for everything that fans out, this thread stays the GL thread
+	JobSystemScope jobs(0);
+
+	//Benchmarks run without a window
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+	{
+		RunBenchmarks();
+		return 0;
+	}
+
+	//Fixed runs without a display for the performance suite
+	HeadlessOptions headless = ParseHeadlessOptions(argc, argv);
+
+	//Headless runs make their own context and load GL with it, GLFW is never initialized for them
+	GLFWwindow* window = nullptr;
+
+	if (headless.enabled)
+	{
+		if (!CreateHeadlessContext(WINDOW_WIDTH, WINDOW_HEIGHT))
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		//Initialize GLFW and create window
+		if (!glfwInit())
+		{
+			std::cout << "Failed to initialize GLFW\n";
+			return -1;
+		}
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Dungeon Crawler", nullptr, nullptr);
+
+		if (window == nullptr)
+		{
+			std::cout << "Failed to create GLFW window\n";
+			glfwTerminate();
+			return -1;
+		}
+
+		glfwMakeContextCurrent(window);
+
+		//Initialize GLAD
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD\n";
+			glfwTerminate();
+			return -1;
+		}
 	}
 
 	//Set up viewport
 	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
 
-	//Hook up window size change callback
-	glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+	if (headless.enabled && !InitializeHeadlessTarget(WINDOW_WIDTH, WINDOW_HEIGHT))
+	{
+		DestroyHeadlessContext();
+		return -1;
+	}
 
-	//Setup mouse input
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetCursorPosCallback(window, MousePositionCallback);
-	glfwSetScrollCallback(window, MouseScrollCallback);
+	//Hook up window size change callback and mouse input, headless runs keep the viewport on their fixed target
+	if (!headless.enabled)
+	{
+		glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetCursorPosCallback(window, MousePositionCallback);
+		glfwSetScrollCallback(window, MouseScrollCallback);
+	}
 
 	//Initialize game systems
+	InitializeGpuProfiler();
 	InitializeCamera();
 	InitializeMap();
 	LoadLevel("levels/00.txt");
+	InitializeEntities();
 	InitializePlayer(0, 0, 0.f);
+	SpawnMonsters(MONSTER_COUNT, 0);
+	SetEntityChaseTarget(GetPlayerEntity());
+
+	//Fog of war starts with nothing explored but what the player can see
+	ResetExplored();
+	UpdatePlayerView();
+	SetMapFieldOfView(&GetPlayerView());
 
 	//Time keeping
-	float deltaTime = 0.f;
-	float previousTime = 0.f;
+	const double simulationStep = 1.0 / SIMULATION_RATE;
+	double previousTime = headless.enabled ? 0.0 : glfwGetTime();
+	double accumulator = 0.0;
+	unsigned int frame = 0;
 
 	//Set up camera
 	SetCameraFOV(75.f);
@@ -177,31 +286,78 @@ int main()
 	glEnable(GL_DEPTH_TEST);
 
 	//Update loop
-	while (!glfwWindowShouldClose(window))
+	if (headless.enabled)
+	{
+		BeginHeadlessRun();
+	}
+
+	while (headless.enabled ? frame < headless.frameCount : !glfwWindowShouldClose(window))
 	{
-		float time = glfwGetTime();
-		deltaTime = time - previousTime;
+		PROFILE_SCOPE("Frame");
+
+		double time = headless.enabled ? (frame + 1) * HEADLESS_FRAME_TIME : glfwGetTime();
+		accumulator += glm::min(time - previousTime, MAX_FRAME_TIME);
 		previousTime = time;
-		
-		ProcessInput(window, deltaTime);
-		TickPlayer(deltaTime);
 
-		//Clear
+		//Step the simulation as many times as the elapsed time covers
+		while (accumulator >= simulationStep)
+		{
+			//Headless runs have no input to read
+			if (!headless.enabled)
+			{
+				ProcessInput(window, (float)simulationStep);
+			}
+
+			TickEntities((float)simulationStep);
+			UpdatePlayerView();
+			accumulator -= simulationStep;
+		}
+
+		//Render between the last two steps by how far we are into the next one
+		InterpolatePlayer((float)(accumulator / simulationStep));
+
+		//GL work jobs handed back to this thread
+		RunMainThreadJobs();
+
+		//Clear, headless runs draw into their own framebuffer
+		glBindFramebuffer(GL_FRAMEBUFFER, GetHeadlessFramebuffer());
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		//Draw
 		DrawMap();
+		DrawEntities((float)(accumulator / simulationStep), GetPlayerEntity(), &GetPlayerView());
+
+		if (!headless.enabled)
+		{
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+
+		//Collect whatever GPU timings have come back since last frame
+		UpdateGpuProfiler();
+		frame++;
+	}
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+	if (headless.enabled)
+	{
+		EndHeadlessRun(headless, frame);
 	}
 
 	//Cleanup
+	CleanupGpuProfiler();
+	CleanupHeadlessTarget();
 	CleanupShaders();
 
-	//Clean up GLFW
-	glfwTerminate();
+	//Clean up the context
+	if (headless.enabled)
+	{
+		DestroyHeadlessContext();
+	}
+	else
+	{
+		glfwTerminate();
+	}
 
 	return 0;
 }
\ No newline at end of file
@@ -2,31 +2,75 @@
 #include <glfw3.h>
 #include "glm/gtc/type_ptr.hpp"
 #include <vector>
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
 
 #include "Map.h"
+#include "LevelFile.h"
 #include "Meshes.h"
 #include "Shader.h"
 #include "Texture.h"
 #include "Camera.h"
+#include "FieldOfView.h"
+#include "Lighting.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 
 using glm::vec3;
 using glm::mat4;
 
-#define MAP_WIDTH 20
-#define MAP_HEIGHT 20
-
-static std::vector<MapTile*> tileRefs;
-static MapTile* tiles[MAP_WIDTH][MAP_HEIGHT];
+//Maps with at least this many tiles are classified on multiple threads
+#define PARALLEL_CLASSIFY_TILES (512 * 512)
+
+//Tile shapes pack type in the low nibble and rotation (in quarter turns) in the high nibble
+#define TILE_SHAPE(type, quarterTurns) ((type) | ((quarterTurns) << 4))
+#define TILE_SHAPE_TYPE(shape) ((MapTileType)((shape) & 0xF))
+#define TILE_SHAPE_ROTATION(shape) (((shape) >> 4) * 90.f)
+
+//Shape for every combination of path neighbors, indexed by north | east << 1 | south << 2 | west << 3
+static const unsigned char tileShapeTable[16] = {
+	TILE_SHAPE(Open, 0),	//none (or not a path tile)
+	TILE_SHAPE(DeadEnd, 2),	//N
+	TILE_SHAPE(DeadEnd, 3),	//E
+	TILE_SHAPE(Corner, 1),	//N E
+	TILE_SHAPE(DeadEnd, 0),	//S
+	TILE_SHAPE(Hallway, 0),	//N S
+	TILE_SHAPE(Corner, 2),	//E S
+	TILE_SHAPE(Wall, 1),	//N E S, wall facing west
+	TILE_SHAPE(DeadEnd, 1),	//W
+	TILE_SHAPE(Corner, 0),	//N W
+	TILE_SHAPE(Hallway, 1),	//E W
+	TILE_SHAPE(Wall, 0),	//N E W, wall facing south
+	TILE_SHAPE(Corner, 3),	//S W
+	TILE_SHAPE(Wall, 3),	//N S W, wall facing east
+	TILE_SHAPE(Wall, 2),	//E S W, wall facing north
+	TILE_SHAPE(Open, 0)		//N E S W
+};
+
+//Spreads the 8 bits of a byte out to bit 0 of 8 separate bytes, filled in on first classify
+static unsigned long long byteSpreadTable[256];
+static bool byteSpreadTableReady = false;
+
+static unsigned int mapWidth;
+static unsigned int mapHeight;
+static unsigned int mapRowWords;
+static std::vector<unsigned long long> pathBits;
+static std::vector<unsigned char> tileShapes;
+static unsigned int mapVersion = 0;
+
+//Baked geometry for a block of tiles, rebuilt only when one of its tiles changes
+struct MapChunk
+{
+	unsigned int vao;
+	unsigned int vbo;
+	unsigned int vertexCount;
+	bool dirty;
+};
 
-static unsigned int openTileVAO;
-static unsigned int wallTileVAO;
-static unsigned int cornerTileVAO;
-static unsigned int hallwayTileVAO;
-static unsigned int deadEndTileVAO;
+static unsigned int chunkCountX;
+static unsigned int chunkCountY;
+static std::vector<MapChunk> chunks;
 
 static unsigned int tileShader;
 static unsigned int modelMatrixUniform;
@@ -34,9 +78,17 @@ static unsigned int viewMatrixUniform;
 static unsigned int projMatrixUniform;
 static unsigned int textureUniform;
 static unsigned int colorUniform;
+static unsigned int visibilityTextureUniform;
+static unsigned int visibilityRectUniform;
+static unsigned int fogEnabledUniform;
 static unsigned int wallTexture;
 static unsigned int groundTexture;
 
+//Visible tiles around the viewer, one byte per tile of the view's window
+static const FieldOfView* mapView = nullptr;
+static unsigned int mapViewVersion;
+static unsigned int visibilityTexture;
+
 //enum MapTileType;
 
 MapTile::MapTile()
@@ -54,48 +106,28 @@ MapTile::MapTile(int x, int y, float angleDegrees, MapTileType type)
 	isPath = false;
 }
 
-void InitializeTileVAO(unsigned int cubeVBO, unsigned int& tileVAO, unsigned int indices[], unsigned int indexCount)
+static void InitializeByteSpreadTable()
 {
-	//Generate and bind VAO
-	glGenVertexArrays(1, &tileVAO);
-	glBindVertexArray(tileVAO);
-
-	//Bind VBO
-	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-
-	//Generate, bind and fill EBO
-	unsigned int tileEBO;
-	glGenBuffers(1, &tileEBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tileEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount, indices, GL_STATIC_DRAW);
-
-	//Set up vertex attributes (position, uv)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	//Unbind buffers
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	if (byteSpreadTableReady)
+	{
+		return;
+	}
+
+	for (unsigned int i = 0; i < 256; i++)
+	{
+		byteSpreadTable[i] = 0ull;
+
+		for (unsigned int bit = 0; bit < 8; bit++)
+		{
+			byteSpreadTable[i] |= (unsigned long long)((i >> bit) & 1) << (bit * 8);
+		}
+	}
+
+	byteSpreadTableReady = true;
 }
 
 void InitializeMap()
 {
-	//Set up tile cube VBO
-	unsigned int cubeVBO;
-	glGenBuffers(1, &cubeVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVerts), cubeVerts, GL_STATIC_DRAW);
-
-	//Set up tile VAOs
-	InitializeTileVAO(cubeVBO, openTileVAO, openTileIndices, sizeof(openTileIndices));
-	InitializeTileVAO(cubeVBO, wallTileVAO, wallTileIndices, sizeof(wallTileIndices));
-	InitializeTileVAO(cubeVBO, cornerTileVAO, cornerTileIndices, sizeof(cornerTileIndices));
-	InitializeTileVAO(cubeVBO, hallwayTileVAO, hallwayTileIndices, sizeof(hallwayTileIndices));
-	InitializeTileVAO(cubeVBO, deadEndTileVAO, deadEndTileIndices, sizeof(deadEndTileIndices));
-
 	//Load shaders and compile program
 	unsigned int vert = CreateShader(VertShader, "shaders/tile.vert");
 	unsigned int frag = CreateShader(FragShader, "shaders/tile.frag");
@@ -105,316 +137,481 @@ void InitializeMap()
 	projMatrixUniform = glGetUniformLocation(tileShader, "projection");
 	textureUniform = glGetUniformLocation(tileShader, "main_tex");
 	colorUniform = glGetUniformLocation(tileShader, "color");
+	visibilityTextureUniform = glGetUniformLocation(tileShader, "visibility_tex");
+	visibilityRectUniform = glGetUniformLocation(tileShader, "visibility_rect");
+	fogEnabledUniform = glGetUniformLocation(tileShader, "fog_enabled");
 
 	//Load textures
 	wallTexture = LoadTexture("textures/wall.jpg");
 	groundTexture = LoadTexture("textures/ground.jpg");
 
-	//Assign textures to shader uniforms
-	//glActiveTexture(GL_TEXTURE0);
-	//glBindTexture(GL_TEXTURE_2D)
-
-	//Create tileRefs
-	//tileRefs.push_back(new MapTile(0, 0, 0.f, Open));
-
-	tileRefs.push_back(new MapTile(0, -2, 0.f, Open));
-	tileRefs.push_back(new MapTile(2, -2, 90.f, Open));
-	tileRefs.push_back(new MapTile(4, -2, 180.f, Open));
-	tileRefs.push_back(new MapTile(6, -2, 270.f, Open));
-
-	tileRefs.push_back(new MapTile(0, 0, 0.f, Wall));
-	tileRefs.push_back(new MapTile(2, 0, 90.f, Wall));
-	tileRefs.push_back(new MapTile(4, 0, 180.f, Wall));
-	tileRefs.push_back(new MapTile(6, 0, 270.f, Wall));
-
-	tileRefs.push_back(new MapTile(0, 2, 0.f, Corner));
-	tileRefs.push_back(new MapTile(2, 2, 90.f, Corner));
-	tileRefs.push_back(new MapTile(4, 2, 180.f, Corner));
-	tileRefs.push_back(new MapTile(6, 2, 270.f, Corner));
-
-	tileRefs.push_back(new MapTile(0, 4, 0.f, Hallway));
-	tileRefs.push_back(new MapTile(2, 4, 90.f, Hallway));
-	tileRefs.push_back(new MapTile(4, 4, 180.f, Hallway));
-	tileRefs.push_back(new MapTile(6, 4, 270.f, Hallway));
-
-	tileRefs.push_back(new MapTile(0, 6, 0.f, DeadEnd));
-	tileRefs.push_back(new MapTile(2, 6, 90.f, DeadEnd));
-	tileRefs.push_back(new MapTile(4, 6, 180.f, DeadEnd));
-	tileRefs.push_back(new MapTile(6, 6, 270.f, DeadEnd));
+	//Anything outside the window samples the black border and counts as not visible
+	const float border[4] = { 0.f, 0.f, 0.f, 0.f };
+	glGenTextures(1, &visibilityTexture);
+	glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void ClearMap()
+static void MarkChunkDirty(unsigned int x, unsigned int y)
+{
+	chunks[(y / MAP_CHUNK_SIZE) * chunkCountX + x / MAP_CHUNK_SIZE].dirty = true;
+}
+
+void MarkMapTileDirty(unsigned int x, unsigned int y)
+{
+	if (x < mapWidth && y < mapHeight)
+	{
+		MarkChunkDirty(x, y);
+	}
+}
+
+//For loaders that already know a chunk has no path tiles, saves scanning it on first draw
+void MarkMapChunkEmpty(unsigned int chunkX, unsigned int chunkY)
+{
+	MapChunk& chunk = chunks[(size_t)chunkY * chunkCountX + chunkX];
+
+	if (chunk.vao == 0)
+	{
+		chunk.vertexCount = 0;
+		chunk.dirty = false;
+	}
+}
+
+static void MarkAllChunksDirty()
 {
-	for (int i = 0; i < tileRefs.size(); i++)
+	for (MapChunk& chunk : chunks)
 	{
-		delete tileRefs[i];
+		chunk.dirty = true;
 	}
+}
+
+static void DeleteChunks()
+{
+	for (MapChunk& chunk : chunks)
+	{
+		if (chunk.vao != 0)
+		{
+			glDeleteVertexArrays(1, &chunk.vao);
+			glDeleteBuffers(1, &chunk.vbo);
+		}
+	}
+
+	chunks.clear();
+}
+
+void ClearMap()
+{
+	mapVersion++;
+	ClearLighting();
+	MarkAllChunksDirty();
+	std::fill(pathBits.begin(), pathBits.end(), 0ull);
+	std::fill(tileShapes.begin(), tileShapes.end(), (unsigned char)TILE_SHAPE(Open, 0));
+}
+
+void ResizeMap(unsigned int width, unsigned int height)
+{
+	mapVersion++;
+	mapWidth = width;
+	mapHeight = height;
+	mapRowWords = (width + 63) / 64;
+
+	pathBits.assign((size_t)mapRowWords * height, 0ull);
+	tileShapes.assign((size_t)width * height, (unsigned char)TILE_SHAPE(Open, 0));
+	ClearLighting();
+
+	//Chunk GL objects are created on first draw
+	DeleteChunks();
+	chunkCountX = (width + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+	chunkCountY = (height + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+	chunks.assign((size_t)chunkCountX * chunkCountY, MapChunk{ 0, 0, 0, true });
+}
+
+unsigned long long* GetMapPathRow(unsigned int y)
+{
+	return &pathBits[(size_t)y * mapRowWords];
+}
+
+unsigned char* GetMapShapeRow(unsigned int y)
+{
+	return &tileShapes[(size_t)y * mapWidth];
+}
 
-	tileRefs.clear();
+unsigned int GetMapRowWords()
+{
+	return mapRowWords;
+}
 
-	for (int x = 0; x < MAP_WIDTH; x++)
+unsigned int GetMapVersion()
+{
+	return mapVersion;
+}
+
+unsigned int GetMapWidth()
+{
+	return mapWidth;
+}
+
+unsigned int GetMapHeight()
+{
+	return mapHeight;
+}
+
+static void ClassifyMapRows(unsigned int firstRow, unsigned int lastRow)
+{
+	for (unsigned int y = firstRow; y < lastRow; y++)
 	{
-		for (int y = 0; y < MAP_WIDTH; y++)
+		const unsigned long long* row = &pathBits[(size_t)y * mapRowWords];
+		const unsigned long long* northRow = y + 1 < mapHeight ? row + mapRowWords : nullptr;
+		const unsigned long long* southRow = y > 0 ? row - mapRowWords : nullptr;
+		unsigned char* shapes = &tileShapes[(size_t)y * mapWidth];
+
+		for (unsigned int w = 0; w < mapRowWords; w++)
 		{
-			delete tiles[x][y];
-			tiles[x][y] = new MapTile(x, y, 0.f, Open);
+			unsigned long long center = row[w];
+
+			//Shift whole words so bit i of each neighbor word lines up with tile i of this word,
+			//then mask with center so non-path tiles land on entry 0 of the shape table
+			unsigned long long north = (northRow ? northRow[w] : 0ull) & center;
+			unsigned long long south = (southRow ? southRow[w] : 0ull) & center;
+			unsigned long long east = ((center >> 1) | (w + 1 < mapRowWords ? row[w + 1] << 63 : 0ull)) & center;
+			unsigned long long west = ((center << 1) | (w > 0 ? row[w - 1] >> 63 : 0ull)) & center;
+
+			unsigned int count = std::min(64u, mapWidth - w * 64);
+			unsigned char* out = shapes + w * 64;
+
+			//Build eight 4-bit neighbor masks at once, one per byte
+			for (unsigned int i = 0; i < count; i += 8)
+			{
+				unsigned long long masks = byteSpreadTable[(north >> i) & 0xFF]
+					| byteSpreadTable[(east >> i) & 0xFF] << 1
+					| byteSpreadTable[(south >> i) & 0xFF] << 2
+					| byteSpreadTable[(west >> i) & 0xFF] << 3;
+
+				unsigned int tileCount = std::min(8u, count - i);
+
+				for (unsigned int j = 0; j < tileCount; j++)
+				{
+					out[i + j] = tileShapeTable[(masks >> (j * 8)) & 0xF];
+				}
+			}
 		}
 	}
 }
 
+void ClassifyMap()
+{
+	PROFILE_SCOPE("Classify map");
+	InitializeByteSpreadTable();
+	MarkAllChunksDirty();
+
+	//Small maps aren't worth handing out as jobs
+	if ((size_t)mapWidth * mapHeight < PARALLEL_CLASSIFY_TILES)
+	{
+		ClassifyMapRows(0, mapHeight);
+		return;
+	}
+
+	//Split the map into horizontal bands, each job only writes its own rows
+	ParallelFor(0, mapHeight, 1, ClassifyMapRows);
+}
+
 void LoadLevel(const char* path)
 {
+	PROFILE_SCOPE("Load level");
+
 	//Clear map
 	ClearMap();
 
-	//Read file
-	std::string data;
-	std::ifstream file;
+	//Binary levels come with their tiles already classified
+	size_t length = strlen(path);
+
+	if (length > 4 && strcmp(path + length - 4, ".lvl") == 0)
+	{
+		if (LoadLevelBinary(path))
+		{
+			LoadOrBakeLighting();
+		}
+
+		return;
+	}
 
-	//Ensure ifstream can throw exceptions
-	file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	if (ImportLevelText(path))
+	{
+		//Initialize tiles to correct type and rotation
+		ClassifyMap();
+		LoadOrBakeLighting();
+	}
+}
 
-	try
+static void ReclassifyTile(unsigned int x, unsigned int y)
+{
+	if (x >= mapWidth || y >= mapHeight)
 	{
-		//Open and read file into stream file
-		file.open(path);
-		std::stringstream stream;
-		stream << file.rdbuf();
+		return;
+	}
 
-		//Close file handler
-		file.close();
+	unsigned int mask = 0;
 
-		//Convert to string
-		data = stream.str();
+	if (IsMapPath(x, y))
+	{
+		//Out of range neighbors wrap to huge coordinates and read as walls
+		mask = (unsigned int)IsMapPath(x, y + 1)
+			| (unsigned int)IsMapPath(x + 1, y) << 1
+			| (unsigned int)IsMapPath(x, y - 1) << 2
+			| (unsigned int)IsMapPath(x - 1, y) << 3;
 	}
-	catch (std::ifstream::failure e)
+
+	tileShapes[(size_t)y * mapWidth + x] = tileShapeTable[mask];
+	MarkChunkDirty(x, y);
+}
+
+void SetMapPath(unsigned int x, unsigned int y, bool isPath)
+{
+	if (x >= mapWidth || y >= mapHeight || IsMapPath(x, y) == isPath)
 	{
-		std::cout << "File read failed!\n";
 		return;
 	}
 
-	int x = 0, y = 0;
-	
-	auto it = data.begin();
+	unsigned long long& word = pathBits[(size_t)y * mapRowWords + x / 64];
+	unsigned long long bit = 1ull << (x % 64);
+	mapVersion++;
 
-	while (it != data.end())
+	if (isPath)
+	{
+		word |= bit;
+	}
+	else
 	{
-		char c = (*it);
+		word &= ~bit;
+	}
 
-		if (c == '*')
-		{
-			tiles[x][y]->isPath = true;
-			x++;
-		}
-		else if (c == '\n')
-		{
-			y++;
-			x = 0;
-		}
-		else
-		{
-			x++;
-		}
+	//Only the tile and its direct neighbors can change shape
+	ReclassifyTile(x, y);
+	ReclassifyTile(x, y + 1);
+	ReclassifyTile(x + 1, y);
+	ReclassifyTile(x, y - 1);
+	ReclassifyTile(x - 1, y);
 
-		if (x > MAP_WIDTH)
-		{
-			std::cout << "Map width exceeded!";
-			return;
-		}
-		
-		if (y > MAP_HEIGHT)
-		{
-			std::cout << "Map height exceeded!";
-			return;
-		}
+	//Light and shadows around the tile have changed too
+	RelightTile(x, y);
+}
+
+static void AppendTileVertices(std::vector<float>& vertices, unsigned int x, unsigned int y)
+{
+	unsigned char shape = tileShapes[(size_t)y * mapWidth + x];
+	const unsigned int* indices = nullptr;
+	unsigned int indexCount = 0;
 
-		it++;
+	switch (TILE_SHAPE_TYPE(shape))
+	{
+	case Open:
+		indices = openTileIndices;
+		indexCount = sizeof(openTileIndices) / sizeof(unsigned int);
+		break;
+	case Wall:
+		indices = wallTileIndices;
+		indexCount = sizeof(wallTileIndices) / sizeof(unsigned int);
+		break;
+	case Corner:
+		indices = cornerTileIndices;
+		indexCount = sizeof(cornerTileIndices) / sizeof(unsigned int);
+		break;
+	case Hallway:
+		indices = hallwayTileIndices;
+		indexCount = sizeof(hallwayTileIndices) / sizeof(unsigned int);
+		break;
+	case DeadEnd:
+		indices = deadEndTileIndices;
+		indexCount = sizeof(deadEndTileIndices) / sizeof(unsigned int);
+		break;
 	}
 
-	//Initialize tiles to correct type and rotation, and fill ref list
-	for (int x = 0; x < MAP_WIDTH; x++)
+	mat4 model = mat4(1.0f);
+	model = glm::translate(model, vec3((float)x, 0.f, (float)y));
+	model = glm::rotate(model, glm::radians(TILE_SHAPE_ROTATION(shape)), glm::vec3(0.f, 1.f, 0.f));
+
+	for (unsigned int i = 0; i < indexCount; i++)
 	{
-		for (int y = 0; y < MAP_WIDTH; y++)
-		{
-			MapTile* tile = tiles[x][y];
+		const float* vertex = &cubeVerts[indices[i] * 5];
+		glm::vec4 position = model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.f);
+
+		vertices.push_back(position.x);
+		vertices.push_back(position.y);
+		vertices.push_back(position.z);
+		vertices.push_back(vertex[3]);
+		vertices.push_back(vertex[4]);
+
+		//Tile vertices all sit on tile corners, which is where lighting is baked
+		vec3 light = GetCornerLight((unsigned int)std::floor(position.x + 1.f), (unsigned int)std::floor(position.z + 1.f));
+		vertices.push_back(light.r);
+		vertices.push_back(light.g);
+		vertices.push_back(light.b);
+	}
+}
 
-			if (tile->isPath)
-			{
+static void RebuildChunk(unsigned int chunkX, unsigned int chunkY)
+{
+	MapChunk& chunk = chunks[(size_t)chunkY * chunkCountX + chunkX];
 
-				bool pathNorth = false;
-				bool pathEast = false;
-				bool pathSouth = false;
-				bool pathWest = false;
+	//Bake every explored path tile in the chunk into world space, walls are hidden so they get no geometry
+	std::vector<float> vertices;
+	unsigned int lastX = std::min((chunkX + 1) * MAP_CHUNK_SIZE, mapWidth);
+	unsigned int lastY = std::min((chunkY + 1) * MAP_CHUNK_SIZE, mapHeight);
 
-				if (y + 1 < MAP_HEIGHT && tiles[x][y + 1]->isPath)
-				{
-					pathNorth = true;
-				}
+	for (unsigned int y = chunkY * MAP_CHUNK_SIZE; y < lastY; y++)
+	{
+		for (unsigned int x = chunkX * MAP_CHUNK_SIZE; x < lastX; x++)
+		{
+			if (IsMapPath(x, y) && IsTileExplored(x, y))
+			{
+				AppendTileVertices(vertices, x, y);
+			}
+		}
+	}
 
-				if (x + 1 < MAP_WIDTH && tiles[x + 1][y]->isPath)
-				{
-					pathEast = true;
-				}
+	if (chunk.vao == 0)
+	{
+		//Generate and bind VAO and VBO
+		glGenVertexArrays(1, &chunk.vao);
+		glBindVertexArray(chunk.vao);
+		glGenBuffers(1, &chunk.vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+
+		//Set up vertex attributes (position, uv, baked light)
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+
+		glBindVertexArray(0);
+	}
 
-				if (y - 1 >= 0 && tiles[x][y - 1]->isPath)
-				{
-					pathSouth = true;
-				}
+	glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-				if (x - 1 >= 0 && tiles[x - 1][y]->isPath)
-				{
-					pathWest = true;
-				}
+	chunk.vertexCount = (unsigned int)(vertices.size() / 8);
+	chunk.dirty = false;
+}
 
-				if (pathNorth && pathEast && pathSouth && pathWest)
-				{
-					tile->type = Open;
-				}
-				else if (pathNorth && pathEast && pathSouth)
-				{
-					//Wall facing west
-					tile->type = Wall;
-					tile->rotation = 90.f;
-				}
-				else if (pathNorth && pathWest && pathSouth)
-				{
-					//Wall facing east
-					tile->type = Wall;
-					tile->rotation = 270.f;
-				}
-				else if (pathNorth && pathWest && pathEast)
-				{
-					//Wall facing south
-					tile->type = Wall;
-					tile->rotation = 0.f;
-				}
-				else if (pathEast && pathWest && pathSouth)
-				{
-					//Wall facing north
-					tile->type = Wall;
-					tile->rotation = 180.f;
-				}
-				else if (pathNorth && pathEast)
-				{
-					//Corner connecting north and east
-					tile->type = Corner;
-					tile->rotation = 90.f;
-				}
-				else if (pathEast && pathSouth)
-				{
-					//Corner connecting east and south
-					tile->type = Corner;
-					tile->rotation = 180.f;
-				}
-				else if (pathSouth && pathWest)
-				{
-					//Corner connecting south and west
-					tile->type = Corner;
-					tile->rotation = 270.f;
-				}
-				else if (pathWest && pathNorth)
-				{
-					//Corner connecting west and north
-					tile->type = Corner;
-					tile->rotation = 0.f;
-				}
-				else if (pathNorth && pathSouth)
-				{
-					//Hallway running north/south
-					tile->type = Hallway;
-					tile->rotation = 0.f;
-				}
-				else if (pathEast && pathWest)
-				{
-					//Hallway running east/west
-					tile->type = Hallway;
-					tile->rotation = 90.f;
-				}
-				else if (pathNorth)
-				{
-					tile->type = DeadEnd;
-					tile->rotation = 180.f;
-				}
-				else if (pathEast)
-				{
-					tile->type = DeadEnd;
-					tile->rotation = 270.f;
-				}
-				else if (pathSouth)
-				{
-					tile->type = DeadEnd;
-					tile->rotation = 0.f;
-				}
-				else if (pathWest)
-				{
-					tile->type = DeadEnd;
-					tile->rotation = 90.f;
-				}
-			}
+void SetMapFieldOfView(const FieldOfView* view)
+{
+	mapView = view;
 
-			tileRefs.push_back(tiles[x][y]);
-		}
+	//Force an upload on the next draw
+	if (view != nullptr)
+	{
+		mapViewVersion = view->version - 1;
 	}
 }
 
-void DrawTile(vec3 position, float rotation, unsigned int tileVAO, unsigned int elementCount)
+static void UploadVisibility()
 {
-	mat4 model = mat4(1.0f);
-	model = glm::translate(model, position);
-	model = glm::rotate(model, glm::radians(rotation), glm::vec3(0.f, 1.f, 0.f));
-	glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(model));
-	glBindVertexArray(tileVAO);
-	glDrawElements(GL_TRIANGLES, elementCount, GL_UNSIGNED_INT, 0);
+	unsigned int windowSize = mapView->radius * 2 + 1;
+	std::vector<unsigned char> texels((size_t)windowSize * windowSize);
+
+	for (unsigned int y = 0; y < windowSize; y++)
+	{
+		for (unsigned int x = 0; x < windowSize; x++)
+		{
+			bool visible = (mapView->visible[(size_t)y * mapView->rowWords + x / 64] >> (x % 64)) & 1ull;
+			texels[(size_t)y * windowSize + x] = visible ? 255 : 0;
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, windowSize, windowSize, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	mapViewVersion = mapView->version;
 }
 
 void DrawMap()
 {
+	PROFILE_SCOPE("Draw map");
+	PROFILE_GPU_SCOPE("Map");
 	glUseProgram(tileShader);
 
+	bool fogEnabled = mapView != nullptr && !mapView->visible.empty();
+	glUniform1i(fogEnabledUniform, fogEnabled);
+
+	if (fogEnabled)
+	{
+		if (mapViewVersion != mapView->version)
+		{
+			UploadVisibility();
+		}
+
+		//Tile centers sit on whole coordinates, so the window starts half a tile before its first center
+		float windowSize = (float)(mapView->radius * 2 + 1);
+		glUniform4f(visibilityRectUniform, mapView->originX - (float)mapView->radius - 0.5f, mapView->originY - (float)mapView->radius - 0.5f, windowSize, windowSize);
+
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+		glUniform1i(visibilityTextureUniform, 1);
+	}
+
 	glUniform4f(colorUniform, 1.0f, 1.0f, 1.0f, 1.0f);
 	glActiveTexture(GL_TEXTURE0);
 	glUniform1i(textureUniform, 0);
 
 	glBindTexture(GL_TEXTURE_2D, wallTexture);
 
-	//Set view and projection matrices
+	//Set view and projection matrices, chunk geometry is already in world space
+	glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(mat4(1.0f)));
 	glUniformMatrix4fv(viewMatrixUniform, 1, GL_FALSE, glm::value_ptr(GetCameraView()));
 	glUniformMatrix4fv(projMatrixUniform, 1, GL_FALSE, glm::value_ptr(GetCameraProjection()));
 
 	//Draw dat map!
-	for (int i = 0; i < tileRefs.size(); i++)
+	for (unsigned int chunkY = 0; chunkY < chunkCountY; chunkY++)
 	{
-		vec3 pos = vec3((float)tileRefs[i]->x, 0.f, (float)tileRefs[i]->y);
-		float rot = tileRefs[i]->rotation;
-
-		switch (tileRefs[i]->type)
+		for (unsigned int chunkX = 0; chunkX < chunkCountX; chunkX++)
 		{
-		case Open:
-			DrawTile(pos, rot, openTileVAO, sizeof(openTileIndices));
-			break;
-		case Wall:
-			DrawTile(pos, rot, wallTileVAO, sizeof(wallTileIndices));
-			break;
-		case Corner:
-			DrawTile(pos, rot, cornerTileVAO, sizeof(cornerTileIndices));
-			break;
-		case Hallway:
-			DrawTile(pos, rot, hallwayTileVAO, sizeof(hallwayTileIndices));
-			break;
-		case DeadEnd:
-			DrawTile(pos, rot, deadEndTileVAO, sizeof(deadEndTileIndices));
-			break;
+			MapChunk& chunk = chunks[(size_t)chunkY * chunkCountX + chunkX];
+
+			if (chunk.dirty)
+			{
+				RebuildChunk(chunkX, chunkY);
+			}
+
+			if (chunk.vertexCount > 0)
+			{
+				glBindVertexArray(chunk.vao);
+				glDrawArrays(GL_TRIANGLES, 0, chunk.vertexCount);
+			}
 		}
 	}
 
+	glBindVertexArray(0);
+}
+
+bool IsMapPath(unsigned int x, unsigned int y)
+{
+	if (x < mapWidth && y < mapHeight)
+	{
+		return (pathBits[(size_t)y * mapRowWords + x / 64] >> (x % 64)) & 1ull;
+	}
+
+	return false;
 }
 
-MapTile* GetMapTile(unsigned int x, unsigned int y)
+MapTile GetMapTile(unsigned int x, unsigned int y)
 {
-	if (x >= 0 && x < MAP_WIDTH && y >= 0 && y < MAP_HEIGHT)
+	if (x < mapWidth && y < mapHeight)
 	{
-		return tiles[x][y];
+		unsigned char shape = tileShapes[(size_t)y * mapWidth + x];
+		MapTile tile(x, y, TILE_SHAPE_ROTATION(shape), TILE_SHAPE_TYPE(shape));
+		tile.isPath = IsMapPath(x, y);
+		return tile;
 	}
 
-	return nullptr;
+	return MapTile(x, y, 0.f, Open);
 }
\ No newline at end of file
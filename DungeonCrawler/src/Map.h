@@ -2,6 +2,9 @@
 
 enum MapTileType { Open, Wall, Corner, Hallway, DeadEnd };
 
+//Tiles are meshed and drawn in square chunks of this many tiles per side
+#define MAP_CHUNK_SIZE 16
+
 struct MapTile
 {
 	int x, y;
@@ -16,4 +19,26 @@ struct MapTile
 void InitializeMap();
 void LoadLevel(const char* path);
 void DrawMap();
-MapTile* GetMapTile(unsigned int x, unsigned int y);
\ No newline at end of file
+
+//Map storage, path bits are packed 64 tiles per word, one row after another
+void ResizeMap(unsigned int width, unsigned int height);
+unsigned long long* GetMapPathRow(unsigned int y);
+unsigned char* GetMapShapeRow(unsigned int y);
+unsigned int GetMapRowWords();
+unsigned int GetMapWidth();
+unsigned int GetMapHeight();
+void ClassifyMap();
+void MarkMapChunkEmpty(unsigned int chunkX, unsigned int chunkY);
+void MarkMapTileDirty(unsigned int x, unsigned int y);
+
+//Tiles outside this view are drawn dimmed, null draws everything at full brightness
+struct FieldOfView;
+void SetMapFieldOfView(const FieldOfView* view);
+
+//Flips a single tile at runtime, only the tile, its neighbors and their chunks are updated
+void SetMapPath(unsigned int x, unsigned int y, bool isPath);
+//Bumped whenever path tiles change, so anything derived from them knows to rebuild
+unsigned int GetMapVersion();
+
+bool IsMapPath(unsigned int x, unsigned int y);
+MapTile GetMapTile(unsigned int x, unsigned int y);
\ No newline at end of file
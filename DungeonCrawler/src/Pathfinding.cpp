@@ -0,0 +1,378 @@
+#include <algorithm>
+#include "Pathfinding.h"
+#include "Map.h"
+#include "JobSystem.h"
+
+//Steps for each direction, same order as MovePlayer (x+, y+, x-, y-)
+static const int directionX[4] = { 1, 0, -1, 0 };
+static const int directionY[4] = { 0, 1, 0, -1 };
+
+struct PathNode
+{
+	unsigned int f, g;
+	unsigned int index;
+};
+
+//Per-thread search state, stamps let a search reuse the arrays without clearing them
+struct SearchScratch
+{
+	std::vector<unsigned int> costs;
+	std::vector<unsigned int> parents;
+	std::vector<unsigned int> stamps;
+	std::vector<PathNode> open;
+	unsigned int stamp;
+};
+
+//Whichever thread runs a query searches with its own, so paths can be found from jobs too
+static thread_local SearchScratch threadScratch;
+
+static bool OpenNodeGreater(const PathNode& a, const PathNode& b)
+{
+	//Prefer deeper nodes on ties, they are closer to the goal
+	return a.f > b.f || (a.f == b.f && a.g < b.g);
+}
+
+static unsigned int Distance(unsigned int ax, unsigned int ay, unsigned int bx, unsigned int by)
+{
+	return (ax > bx ? ax - bx : bx - ax) + (ay > by ? ay - by : by - ay);
+}
+
+static void BeginSearch(SearchScratch& scratch)
+{
+	size_t tileCount = (size_t)GetMapWidth() * GetMapHeight();
+
+	if (scratch.stamps.size() != tileCount)
+	{
+		scratch.costs.resize(tileCount);
+		scratch.parents.resize(tileCount);
+		scratch.stamps.assign(tileCount, 0);
+		scratch.stamp = 0;
+	}
+
+	//Stamp wrapped around, old stamps could look current again
+	if (++scratch.stamp == 0)
+	{
+		std::fill(scratch.stamps.begin(), scratch.stamps.end(), 0);
+		scratch.stamp = 1;
+	}
+
+	scratch.open.clear();
+}
+
+static void PushNode(SearchScratch& scratch, unsigned int index, unsigned int g, unsigned int h, unsigned int parent)
+{
+	scratch.costs[index] = g;
+	scratch.parents[index] = parent;
+	scratch.stamps[index] = scratch.stamp;
+	scratch.open.push_back(PathNode{ g + h, g, index });
+	std::push_heap(scratch.open.begin(), scratch.open.end(), OpenNodeGreater);
+}
+
+static bool IsBetter(const SearchScratch& scratch, unsigned int index, unsigned int g)
+{
+	return scratch.stamps[index] != scratch.stamp || g < scratch.costs[index];
+}
+
+static bool PopNode(SearchScratch& scratch, PathNode& node)
+{
+	while (!scratch.open.empty())
+	{
+		std::pop_heap(scratch.open.begin(), scratch.open.end(), OpenNodeGreater);
+		node = scratch.open.back();
+		scratch.open.pop_back();
+
+		//Skip entries that were superseded by a cheaper route
+		if (node.g == scratch.costs[node.index])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool SearchAStar(SearchScratch& scratch, const PathQuery& query)
+{
+	unsigned int width = GetMapWidth();
+	unsigned int goal = query.goalY * width + query.goalX;
+
+	PushNode(scratch, query.startY * width + query.startX, 0, Distance(query.startX, query.startY, query.goalX, query.goalY), query.startY * width + query.startX);
+
+	PathNode node;
+
+	while (PopNode(scratch, node))
+	{
+		if (node.index == goal)
+		{
+			return true;
+		}
+
+		unsigned int x = node.index % width;
+		unsigned int y = node.index / width;
+
+		for (int direction = 0; direction < 4; direction++)
+		{
+			//Stepping off the low edge wraps to a huge coordinate, which IsMapPath rejects
+			unsigned int nx = x + directionX[direction];
+			unsigned int ny = y + directionY[direction];
+
+			if (!IsMapPath(nx, ny))
+			{
+				continue;
+			}
+
+			unsigned int index = ny * width + nx;
+			unsigned int g = node.g + 1;
+
+			if (IsBetter(scratch, index, g))
+			{
+				PushNode(scratch, index, g, Distance(nx, ny, query.goalX, query.goalY), node.index);
+			}
+		}
+	}
+
+	return false;
+}
+
+//Horizontal jumps stop at the goal or where a vertical neighbor opens up behind a wall (a forced neighbor)
+static bool JumpHorizontal(unsigned int x, unsigned int y, int dx, const PathQuery& query, unsigned int& jumpX)
+{
+	while (true)
+	{
+		x += dx;
+
+		if (!IsMapPath(x, y))
+		{
+			return false;
+		}
+
+		if ((x == query.goalX && y == query.goalY)
+			|| (IsMapPath(x, y + 1) && !IsMapPath(x - dx, y + 1))
+			|| (IsMapPath(x, y - 1) && !IsMapPath(x - dx, y - 1)))
+		{
+			jumpX = x;
+			return true;
+		}
+	}
+}
+
+//Vertical moves may turn horizontal anywhere, so they stop wherever a horizontal jump would succeed
+static bool JumpVertical(unsigned int x, unsigned int y, int dy, const PathQuery& query, unsigned int& jumpY)
+{
+	unsigned int jumpX;
+
+	while (true)
+	{
+		y += dy;
+
+		if (!IsMapPath(x, y))
+		{
+			return false;
+		}
+
+		if ((x == query.goalX && y == query.goalY)
+			|| JumpHorizontal(x, y, 1, query, jumpX)
+			|| JumpHorizontal(x, y, -1, query, jumpX))
+		{
+			jumpY = y;
+			return true;
+		}
+	}
+}
+
+static bool SearchJumpPoint(SearchScratch& scratch, const PathQuery& query)
+{
+	unsigned int width = GetMapWidth();
+	unsigned int goal = query.goalY * width + query.goalX;
+
+	PushNode(scratch, query.startY * width + query.startX, 0, Distance(query.startX, query.startY, query.goalX, query.goalY), query.startY * width + query.startX);
+
+	PathNode node;
+
+	while (PopNode(scratch, node))
+	{
+		if (node.index == goal)
+		{
+			return true;
+		}
+
+		unsigned int x = node.index % width;
+		unsigned int y = node.index / width;
+		unsigned int parent = scratch.parents[node.index];
+		unsigned int parentX = parent % width;
+		unsigned int parentY = parent / width;
+
+		for (int direction = 0; direction < 4; direction++)
+		{
+			int dx = directionX[direction];
+			int dy = directionY[direction];
+			unsigned int jumpX = x;
+			unsigned int jumpY = y;
+
+			//Never turn back the way we came, the jumps themselves do the rest of the pruning
+			if ((dx != 0 && parentX != x && (parentX < x) != (dx > 0))
+				|| (dy != 0 && parentY != y && (parentY < y) != (dy > 0)))
+			{
+				continue;
+			}
+
+			if (dx != 0)
+			{
+				if (!JumpHorizontal(x, y, dx, query, jumpX))
+				{
+					continue;
+				}
+			}
+			else if (!JumpVertical(x, y, dy, query, jumpY))
+			{
+				continue;
+			}
+
+			unsigned int index = jumpY * width + jumpX;
+			unsigned int g = node.g + Distance(x, y, jumpX, jumpY);
+
+			if (IsBetter(scratch, index, g))
+			{
+				PushNode(scratch, index, g, Distance(jumpX, jumpY, query.goalX, query.goalY), node.index);
+			}
+		}
+	}
+
+	return false;
+}
+
+static void SolveQuery(SearchScratch& scratch, const PathQuery& query, PathAlgorithm algorithm, PathResult& result)
+{
+	result.found = false;
+	result.tiles.clear();
+
+	if (!IsMapPath(query.startX, query.startY) || !IsMapPath(query.goalX, query.goalY))
+	{
+		return;
+	}
+
+	BeginSearch(scratch);
+
+	bool found = algorithm == JumpPoint ? SearchJumpPoint(scratch, query) : SearchAStar(scratch, query);
+
+	if (!found)
+	{
+		return;
+	}
+
+	//Walk back from the goal, filling in the straight runs between jump points
+	unsigned int width = GetMapWidth();
+	unsigned int index = query.goalY * width + query.goalX;
+	unsigned int start = query.startY * width + query.startX;
+	glm::ivec2 tile(query.goalX, query.goalY);
+
+	result.tiles.push_back(tile);
+
+	while (index != start)
+	{
+		unsigned int parent = scratch.parents[index];
+		glm::ivec2 parentTile(parent % width, parent / width);
+		glm::ivec2 step = glm::sign(parentTile - tile);
+
+		while (tile != parentTile)
+		{
+			tile += step;
+			result.tiles.push_back(tile);
+		}
+
+		index = parent;
+	}
+
+	std::reverse(result.tiles.begin(), result.tiles.end());
+	result.found = true;
+}
+
+void FindPaths(const PathQuery* queries, PathResult* results, unsigned int count, PathAlgorithm algorithm)
+{
+	ParallelFor(0, count, 1, [queries, results, algorithm](unsigned int first, unsigned int last)
+	{
+		for (unsigned int i = first; i < last; i++)
+		{
+			SolveQuery(threadScratch, queries[i], algorithm, results[i]);
+		}
+	});
+}
+
+PathResult FindPath(const PathQuery& query, PathAlgorithm algorithm)
+{
+	PathResult result;
+	SolveQuery(threadScratch, query, algorithm, result);
+	return result;
+}
+
+void BuildFlowField(FlowField& field, unsigned int goalX, unsigned int goalY)
+{
+	field.goalX = goalX;
+	field.goalY = goalY;
+	field.width = GetMapWidth();
+	field.height = GetMapHeight();
+
+	size_t tileCount = (size_t)field.width * field.height;
+	field.distances.assign(tileCount, FLOW_UNREACHABLE);
+	field.directions.assign(tileCount, FLOW_NO_DIRECTION);
+
+	if (!IsMapPath(goalX, goalY))
+	{
+		return;
+	}
+
+	//Breadth first flood out from the goal, every step costs the same
+	std::vector<unsigned int> frontier;
+	frontier.push_back(goalY * field.width + goalX);
+	field.distances[frontier[0]] = 0;
+
+	for (size_t head = 0; head < frontier.size(); head++)
+	{
+		unsigned int index = frontier[head];
+		unsigned int x = index % field.width;
+		unsigned int y = index / field.width;
+
+		for (int direction = 0; direction < 4; direction++)
+		{
+			unsigned int nx = x + directionX[direction];
+			unsigned int ny = y + directionY[direction];
+
+			if (!IsMapPath(nx, ny))
+			{
+				continue;
+			}
+
+			unsigned int neighbor = ny * field.width + nx;
+
+			if (field.distances[neighbor] != FLOW_UNREACHABLE)
+			{
+				continue;
+			}
+
+			//Neighbor moves back towards this tile, the opposite direction
+			field.distances[neighbor] = field.distances[index] + 1;
+			field.directions[neighbor] = (unsigned char)((direction + 2) % 4);
+			frontier.push_back(neighbor);
+		}
+	}
+}
+
+unsigned int GetFlowDistance(const FlowField& field, unsigned int x, unsigned int y)
+{
+	if (x < field.width && y < field.height)
+	{
+		return field.distances[y * field.width + x];
+	}
+
+	return FLOW_UNREACHABLE;
+}
+
+unsigned char GetFlowDirection(const FlowField& field, unsigned int x, unsigned int y)
+{
+	if (x < field.width && y < field.height)
+	{
+		return field.directions[y * field.width + x];
+	}
+
+	return FLOW_NO_DIRECTION;
+}
\ No newline at end of file
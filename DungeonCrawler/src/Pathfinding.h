@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+
+enum PathAlgorithm { AStar, JumpPoint };
+
+struct PathQuery
+{
+	unsigned int startX, startY;
+	unsigned int goalX, goalY;
+};
+
+struct PathResult
+{
+	bool found;
+	//Every tile from start to goal, both included
+	std::vector<glm::ivec2> tiles;
+};
+
+//Distance and direction to a shared goal for every tile, directions use the MovePlayer convention
+struct FlowField
+{
+	unsigned int goalX, goalY;
+	unsigned int width, height;
+	std::vector<unsigned int> distances;
+	std::vector<unsigned char> directions;
+};
+
+#define FLOW_UNREACHABLE 0xFFFFFFFF
+#define FLOW_NO_DIRECTION 0xFF
+
+//Answers a batch of queries across the job threads, blocks until every result is filled in.
+//Both can be called from jobs. The map must not be edited while a search is running.
+void FindPaths(const PathQuery* queries, PathResult* results, unsigned int count, PathAlgorithm algorithm);
+PathResult FindPath(const PathQuery& query, PathAlgorithm algorithm);
+
+void BuildFlowField(FlowField& field, unsigned int goalX, unsigned int goalY);
+unsigned int GetFlowDistance(const FlowField& field, unsigned int x, unsigned int y);
+unsigned char GetFlowDirection(const FlowField& field, unsigned int x, unsigned int y);
\ No newline at end of file
@@ -1,101 +1,51 @@
-#include <iostream>
-#include "glm/common.hpp"
 #include "Camera.h"
 #include "Player.h"
-#include "Map.h"
 
-using glm::vec3;
+#define PLAYER_SIGHT_RADIUS 12
 
-static unsigned int playerX, playerY, prevPlayerX, prevPlayerY;
-
-static float playerRotation, prevRotation;
-static float turnTimer;
+//The player is an ordinary entity, ticked along with everything else by TickEntities
+static Entity player = NULL_ENTITY;
+static FieldOfView playerView;
 
 void InitializePlayer(unsigned int x, unsigned int y, float rotation)
 {
-	playerX = x;
-	playerY = y;
-	playerRotation = rotation;
+	player = CreateEntity(x, y, (int)(rotation / 90.f), NoBrain);
 }
 
-void MovePlayer(unsigned int direction)
+Entity GetPlayerEntity()
 {
-	if (turnTimer < 1.f)
-	{
-		return;
-	}
-
-	prevPlayerX = playerX;
-	prevPlayerY = playerY;
-	prevRotation = playerRotation;
-
-	direction += (int)(playerRotation / 90.f);
-	direction = direction % 4;
-
-	std::cout << direction << std::endl;
-
-	switch (direction)
-	{
-	case 0: playerX++; break;
-	case 1: playerY++; break;
-	case 2: playerX--; break;
-	case 3: playerY--; break;
-	}
-
-	//Check for wall
-	MapTile* tile = GetMapTile(playerX, playerY);
-
-	if (tile == nullptr || !tile->isPath)
-	{
-		playerX = prevPlayerX;
-		playerY = prevPlayerY;
-		return;
-	}
+	return player;
+}
 
-	turnTimer = 0.f;
+void MovePlayer(unsigned int direction)
+{
+	MoveEntity(player, direction);
 }
 
 void RotatePlayer(bool clockwise)
 {
-	if (turnTimer < 1.f)
-	{
-		return;
-	}
+	RotateEntity(player, clockwise);
+}
 
-	prevRotation = playerRotation;
-	prevPlayerX = playerX;
-	prevPlayerY = playerY;
+void UpdatePlayerView()
+{
+	glm::ivec2 cell = GetEntityCell(player);
 
-	if (clockwise)
-	{
-		playerRotation += 90.f;
-	}
-	else
+	//The cell changes as soon as a move starts, so the view is ready before the tween gets there
+	if (UpdateFieldOfView(playerView, cell.x, cell.y, PLAYER_SIGHT_RADIUS))
 	{
-		playerRotation -= 90.f;
+		MarkExplored(playerView);
 	}
-
-	turnTimer = 0.f;
 }
 
-void TickPlayer(float dt)
+const FieldOfView& GetPlayerView()
 {
-	vec3 position((float)playerX, 0.f, (float)playerY);
-	vec3 oldPosition((float)prevPlayerX, 0.f, (float)prevPlayerY);
-
-	float turnTimerClamped = glm::min(turnTimer, 1.f);
-
-	float smoothed = glm::smoothstep(0.f, 1.f, turnTimerClamped);
-
-	vec3 lerpPos = glm::mix(oldPosition, position, smoothed);
-	float lerpRot = glm::mix(prevRotation, playerRotation, smoothed);
-	
-
+	return playerView;
+}
 
+void InterpolatePlayer(float alpha)
+{
 	//Update camera
-	SetCameraPosition(lerpPos);
-	SetCameraRotation(glm::vec3(0.f, lerpRot, 0.f));
-
-	//Update timer
-	turnTimer += dt * 2.f;
+	SetCameraPosition(GetEntityRenderPosition(player, alpha));
+	SetCameraRotation(glm::vec3(0.f, GetEntityRenderRotation(player, alpha), 0.f));
 }
\ No newline at end of file
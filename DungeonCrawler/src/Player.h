@@ -1,8 +1,14 @@
 #pragma once
 
-
+#include "Entities.h"
+#include "FieldOfView.h"
 
 void InitializePlayer(unsigned int x, unsigned int y, float rotation);
+Entity GetPlayerEntity();
 void MovePlayer(unsigned int direction);
 void RotatePlayer(bool clockwise);
-void TickPlayer(float dt);
\ No newline at end of file
+//Refreshes what the player can see and marks it explored, cheap when the player hasn't moved
+void UpdatePlayerView();
+const FieldOfView& GetPlayerView();
+//Places the camera between the last two simulation steps, alpha 0 is the previous step and 1 the latest
+void InterpolatePlayer(float alpha);
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <vector>
 #include <algorithm>
 #include "Shader.h"
+#include "Profiler.h"
 
 using std::string;
 using std::ifstream;
@@ -32,6 +33,8 @@ static bool ProgramSuccess(unsigned int programID)
 
 unsigned int CreateShader(ShaderType type, const char* filePath)
 {
+	PROFILE_SCOPE("Compile shader");
+
 	//Read file
 	string data;
 	ifstream file;
@@ -0,0 +1,387 @@
+//Before glad, which otherwise defines APIENTRY itself
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <glad.h>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include "Headless.h"
+
+#ifdef _WIN32
+#define OSMESA_LIBRARY "osmesa.dll"
+#else
+#define OSMESA_LIBRARY "libOSMesa.so.8"
+#endif
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+//The parts of GL/osmesa.h used here, the library is loaded at runtime so building doesn't need Mesa
+#define OSMESA_FORMAT 0x22
+#define OSMESA_DEPTH_BITS 0x30
+#define OSMESA_STENCIL_BITS 0x31
+#define OSMESA_PROFILE 0x33
+#define OSMESA_CORE_PROFILE 0x34
+#define OSMESA_CONTEXT_MAJOR_VERSION 0x36
+#define OSMESA_CONTEXT_MINOR_VERSION 0x37
+
+typedef struct osmesa_context* OSMesaContext;
+typedef void (*OSMesaProc)();
+typedef OSMesaContext (APIENTRY* OSMesaCreateContextAttribsFunction)(const int* attributes, OSMesaContext shared);
+typedef unsigned char (APIENTRY* OSMesaMakeCurrentFunction)(OSMesaContext context, void* buffer, unsigned int type, int width, int height);
+typedef void (APIENTRY* OSMesaDestroyContextFunction)(OSMesaContext context);
+typedef OSMesaProc (APIENTRY* OSMesaGetProcAddressFunction)(const char* name);
+
+static unsigned int framebuffer = 0;
+static unsigned int colorBuffer = 0;
+static unsigned int depthBuffer = 0;
+static unsigned int targetWidth = 0;
+static unsigned int targetHeight = 0;
+static std::chrono::steady_clock::time_point runStart;
+
+#ifndef _WIN32
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+static EGLSurface eglSurface = EGL_NO_SURFACE;
+#endif
+
+#ifdef _WIN32
+static HMODULE osMesaLibrary = nullptr;
+#else
+static void* osMesaLibrary = nullptr;
+#endif
+static OSMesaContext osMesaContext = nullptr;
+static OSMesaGetProcAddressFunction osMesaGetProcAddress = nullptr;
+static OSMesaDestroyContextFunction osMesaDestroyContext = nullptr;
+//OSMesa always draws to a buffer of ours, even though frames go to the headless framebuffer
+static std::vector<unsigned char> osMesaBuffer;
+
+HeadlessOptions ParseHeadlessOptions(int argc, char** argv)
+{
+	HeadlessOptions options = { false, HEADLESS_DEFAULT_FRAMES, nullptr };
+
+	if (argc < 2 || strcmp(argv[1], "--headless") != 0)
+	{
+		return options;
+	}
+
+	options.enabled = true;
+
+	if (argc > 2)
+	{
+		int frames = atoi(argv[2]);
+
+		if (frames > 0)
+		{
+			options.frameCount = frames;
+		}
+		else
+		{
+			std::cout << "Frame count '" << argv[2] << "' isn't a positive number, drawing " << HEADLESS_DEFAULT_FRAMES << " frames\n";
+		}
+	}
+
+	if (argc > 3)
+	{
+		options.imagePath = argv[3];
+	}
+
+	return options;
+}
+
+#ifndef _WIN32
+static void DestroyEglContext()
+{
+	if (eglDisplay == EGL_NO_DISPLAY)
+	{
+		return;
+	}
+
+	eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if (eglSurface != EGL_NO_SURFACE)
+	{
+		eglDestroySurface(eglDisplay, eglSurface);
+	}
+
+	if (eglContext != EGL_NO_CONTEXT)
+	{
+		eglDestroyContext(eglDisplay, eglContext);
+	}
+
+	eglTerminate(eglDisplay);
+	eglDisplay = EGL_NO_DISPLAY;
+	eglContext = EGL_NO_CONTEXT;
+	eglSurface = EGL_NO_SURFACE;
+}
+
+//Mesa's surfaceless platform needs neither a display server nor a GPU, other drivers get their default display
+static bool CreateEglContext(unsigned int width, unsigned int height)
+{
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (clientExtensions != nullptr && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr && getPlatformDisplay != nullptr)
+	{
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+
+	if (eglDisplay == EGL_NO_DISPLAY)
+	{
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+	{
+		eglDisplay = EGL_NO_DISPLAY;
+		return false;
+	}
+
+	EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+	EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3, EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+
+	if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0 || !eglBindAPI(EGL_OPENGL_API))
+	{
+		DestroyEglContext();
+		return false;
+	}
+
+	eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+
+	if (eglContext == EGL_NO_CONTEXT)
+	{
+		DestroyEglContext();
+		return false;
+	}
+
+	//Frames go to the headless framebuffer, a surface is only made for drivers that can't go without one
+	const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+
+	if (extensions == nullptr || strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr)
+	{
+		EGLint surfaceAttributes[] = { EGL_WIDTH, (EGLint)width, EGL_HEIGHT, (EGLint)height, EGL_NONE };
+		eglSurface = eglCreatePbufferSurface(eglDisplay, config, surfaceAttributes);
+
+		if (eglSurface == EGL_NO_SURFACE)
+		{
+			DestroyEglContext();
+			return false;
+		}
+	}
+
+	if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext) || !gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		DestroyEglContext();
+		return false;
+	}
+
+	return true;
+}
+#endif
+
+static void* LoadOSMesaFunction(const char* name)
+{
+#ifdef _WIN32
+	return (void*)GetProcAddress(osMesaLibrary, name);
+#else
+	return dlsym(osMesaLibrary, name);
+#endif
+}
+
+static void* GetOSMesaProcAddress(const char* name)
+{
+	return (void*)osMesaGetProcAddress(name);
+}
+
+static void DestroyOSMesaContext()
+{
+	if (osMesaContext != nullptr)
+	{
+		osMesaDestroyContext(osMesaContext);
+		osMesaContext = nullptr;
+	}
+
+	if (osMesaLibrary != nullptr)
+	{
+#ifdef _WIN32
+		FreeLibrary(osMesaLibrary);
+#else
+		dlclose(osMesaLibrary);
+#endif
+		osMesaLibrary = nullptr;
+	}
+
+	osMesaBuffer = std::vector<unsigned char>();
+}
+
+//Software rendering, for where there is no EGL
+static bool CreateOSMesaContext(unsigned int width, unsigned int height)
+{
+#ifdef _WIN32
+	osMesaLibrary = LoadLibraryA(OSMESA_LIBRARY);
+#else
+	osMesaLibrary = dlopen(OSMESA_LIBRARY, RTLD_NOW | RTLD_LOCAL);
+#endif
+
+	if (osMesaLibrary == nullptr)
+	{
+		return false;
+	}
+
+	OSMesaCreateContextAttribsFunction createContext = (OSMesaCreateContextAttribsFunction)LoadOSMesaFunction("OSMesaCreateContextAttribs");
+	OSMesaMakeCurrentFunction makeCurrent = (OSMesaMakeCurrentFunction)LoadOSMesaFunction("OSMesaMakeCurrent");
+	osMesaDestroyContext = (OSMesaDestroyContextFunction)LoadOSMesaFunction("OSMesaDestroyContext");
+	osMesaGetProcAddress = (OSMesaGetProcAddressFunction)LoadOSMesaFunction("OSMesaGetProcAddress");
+
+	if (createContext == nullptr || makeCurrent == nullptr || osMesaDestroyContext == nullptr || osMesaGetProcAddress == nullptr)
+	{
+		DestroyOSMesaContext();
+		return false;
+	}
+
+	int attributes[] = { OSMESA_FORMAT, GL_RGBA, OSMESA_DEPTH_BITS, 24, OSMESA_STENCIL_BITS, 8, OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 3, OSMESA_CONTEXT_MINOR_VERSION, 3, 0 };
+	osMesaContext = createContext(attributes, nullptr);
+	osMesaBuffer.resize((size_t)width * height * 4);
+
+	if (osMesaContext == nullptr || !makeCurrent(osMesaContext, osMesaBuffer.data(), GL_UNSIGNED_BYTE, width, height) || !gladLoadGLLoader(GetOSMesaProcAddress))
+	{
+		DestroyOSMesaContext();
+		return false;
+	}
+
+	return true;
+}
+
+bool CreateHeadlessContext(unsigned int width, unsigned int height)
+{
+#ifndef _WIN32
+	if (CreateEglContext(width, height))
+	{
+		return true;
+	}
+
+	std::cout << "No EGL context, trying OSMesa\n";
+#endif
+
+	if (CreateOSMesaContext(width, height))
+	{
+		return true;
+	}
+
+	std::cout << "Failed to create a headless GL context, needs EGL or " << OSMESA_LIBRARY << "\n";
+	return false;
+}
+
+void DestroyHeadlessContext()
+{
+#ifndef _WIN32
+	DestroyEglContext();
+#endif
+	DestroyOSMesaContext();
+}
+
+bool InitializeHeadlessTarget(unsigned int width, unsigned int height)
+{
+	targetWidth = width;
+	targetHeight = height;
+
+	//Headless contexts have no window framebuffer of their own, so frames are drawn here instead
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Headless framebuffer incomplete\n";
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		CleanupHeadlessTarget();
+		return false;
+	}
+
+	return true;
+}
+
+unsigned int GetHeadlessFramebuffer()
+{
+	return framebuffer;
+}
+
+void CleanupHeadlessTarget()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+}
+
+//GL rows run bottom up, PPM rows top down
+static bool WriteHeadlessImage(const char* path)
+{
+	std::vector<unsigned char> pixels((size_t)targetWidth * targetHeight * 3);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, targetWidth, targetHeight, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	std::ofstream file(path, std::ios::binary);
+
+	if (!file)
+	{
+		std::cout << "Couldn't write frame image " << path << "\n";
+		return false;
+	}
+
+	file << "P6\n" << targetWidth << " " << targetHeight << "\n255\n";
+
+	for (unsigned int y = targetHeight; y > 0; y--)
+	{
+		file.write((const char*)&pixels[(size_t)(y - 1) * targetWidth * 3], (std::streamsize)targetWidth * 3);
+	}
+
+	std::cout << "Wrote last frame to " << path << "\n";
+	return true;
+}
+
+void BeginHeadlessRun()
+{
+	glFinish();
+	runStart = std::chrono::steady_clock::now();
+}
+
+void EndHeadlessRun(const HeadlessOptions& options, unsigned int framesDrawn)
+{
+	glFinish();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+	std::cout << "Drew " << framesDrawn << " frames at " << targetWidth << "x" << targetHeight << " in " << seconds << " s, " << (framesDrawn > 0 ? seconds * 1000.0 / framesDrawn : 0.0) << " ms per frame\n";
+
+	if (options.imagePath != nullptr)
+	{
+		WriteHeadlessImage(options.imagePath);
+	}
+}
\ No newline at end of file
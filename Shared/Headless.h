@@ -0,0 +1,35 @@
+#pragma once
+
+//Running with --headless [frames] [image path] draws a fixed number of frames without a window into an
+//offscreen framebuffer, with a fixed time step so every run draws the same frames. The timings are printed
+//at the end and the last frame can be written out as a PPM to compare against.
+
+#define HEADLESS_DEFAULT_FRAMES 300
+//Simulated seconds per frame
+#define HEADLESS_FRAME_TIME (1.0 / 60.0)
+
+struct HeadlessOptions
+{
+	bool enabled;
+	unsigned int frameCount;
+	//Where the last frame goes, nullptr to skip it
+	const char* imagePath;
+};
+
+HeadlessOptions ParseHeadlessOptions(int argc, char** argv);
+
+//GL 3.3 core context made current and loaded into glad without GLFW, which would need a display server.
+//EGL without a surface where there is EGL, otherwise software OSMesa loaded at runtime. False if neither works.
+bool CreateHeadlessContext(unsigned int width, unsigned int height);
+void DestroyHeadlessContext();
+
+//Framebuffer that stands in for the window's, needs GL loaded
+bool InitializeHeadlessTarget(unsigned int width, unsigned int height);
+//0 when not running headless, so it can always be bound in place of the window's framebuffer
+unsigned int GetHeadlessFramebuffer();
+void CleanupHeadlessTarget();
+
+//Call right before the first frame
+void BeginHeadlessRun();
+//Waits for the GPU to finish, prints the timings and writes the last frame if asked to
+void EndHeadlessRun(const HeadlessOptions& options, unsigned int framesDrawn);
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include <thread>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <condition_variable>
+#include "JobSystem.h"
+
+//Chunks per thread a parallel for is split into, spares let threads that finish early take over from slow ones
+#define JOB_CHUNKS_PER_THREAD 4
+
+struct JobQueue
+{
+	std::mutex lock;
+	std::deque<PendingJob> jobs;
+};
+
+//Queue 0 is the main thread's, threads outside the pool push to it as well
+static std::vector<std::unique_ptr<JobQueue>> queues;
+static std::vector<std::thread> workers;
+static thread_local unsigned int threadQueue = 0;
+static std::thread::id mainThreadId = std::this_thread::get_id();
+
+//Jobs sitting in any queue, idle workers sleep while there are none
+static std::atomic<int> queuedJobs(0);
+static std::mutex sleepLock;
+static std::condition_variable sleepCondition;
+static bool stopWorkers = false;
+
+static std::mutex mainJobsLock;
+static std::vector<PendingJob> mainJobs;
+
+static void Enqueue(PendingJob job);
+
+static void Execute(PendingJob& job)
+{
+	job.job();
+	job.job = nullptr;
+
+	if (!job.counter)
+	{
+		return;
+	}
+
+	//Lowered under the lock so a dependent queued at the same time is either released here or sees zero
+	std::vector<PendingJob> released;
+
+	{
+		std::lock_guard<std::mutex> lock(job.counter->dependentsLock);
+
+		if (--job.counter->remaining == 0)
+		{
+			released.swap(job.counter->dependents);
+		}
+	}
+
+	for (PendingJob& dependent : released)
+	{
+		Enqueue(std::move(dependent));
+	}
+}
+
+static void Enqueue(PendingJob job)
+{
+	if (job.mainThread)
+	{
+		std::lock_guard<std::mutex> lock(mainJobsLock);
+		mainJobs.push_back(std::move(job));
+		return;
+	}
+
+	//Nothing would take it off a queue but a wait, so without workers it runs now
+	if (queues.size() < 2)
+	{
+		Execute(job);
+		return;
+	}
+
+	{
+		JobQueue& queue = *queues[threadQueue];
+		std::lock_guard<std::mutex> lock(queue.lock);
+		queue.jobs.push_back(std::move(job));
+	}
+
+	//Taking the sleep lock after the count went up means a worker can't miss it between checking and sleeping
+	queuedJobs++;
+
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+	}
+
+	sleepCondition.notify_one();
+}
+
+//Newest job of the thread's own queue while its data is still warm, otherwise the oldest of another queue
+static bool TakeJob(PendingJob& job)
+{
+	unsigned int queueCount = (unsigned int)queues.size();
+
+	for (unsigned int i = 0; i < queueCount; i++)
+	{
+		JobQueue& queue = *queues[(threadQueue + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.lock);
+
+		if (!queue.jobs.empty())
+		{
+			if (i == 0)
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+			}
+
+			queuedJobs--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void WorkerLoop(unsigned int index)
+{
+	threadQueue = index;
+	PendingJob job;
+
+	while (true)
+	{
+		if (TakeJob(job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepLock);
+		sleepCondition.wait(lock, [] { return queuedJobs > 0 || stopWorkers; });
+
+		if (stopWorkers)
+		{
+			return;
+		}
+	}
+}
+
+static void QueueJob(JobCounter* dependency, Job job, JobCounter* counter, bool mainThread)
+{
+	if (counter)
+	{
+		counter->remaining++;
+	}
+
+	PendingJob pending = { std::move(job), counter, mainThread };
+
+	if (dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->dependentsLock);
+
+		if (dependency->remaining > 0)
+		{
+			dependency->dependents.push_back(std::move(pending));
+			return;
+		}
+	}
+
+	Enqueue(std::move(pending));
+}
+
+void InitializeJobs(unsigned int workerCount)
+{
+	ShutdownJobs();
+
+	if (workerCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? cores - 1 : 0;
+	}
+
+	mainThreadId = std::this_thread::get_id();
+	threadQueue = 0;
+	stopWorkers = false;
+
+	for (unsigned int i = 0; i <= workerCount; i++)
+	{
+		queues.push_back(std::make_unique<JobQueue>());
+	}
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		workers.push_back(std::thread(WorkerLoop, i + 1));
+	}
+}
+
+void ShutdownJobs()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+		stopWorkers = true;
+	}
+
+	sleepCondition.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	workers.clear();
+
+	//Anything still queued runs here so no counter is left waiting
+	PendingJob job;
+
+	while (TakeJob(job))
+	{
+		Execute(job);
+	}
+
+	queues.clear();
+}
+
+unsigned int GetJobThreadCount()
+{
+	return std::max(1u, (unsigned int)queues.size());
+}
+
+void RunJob(Job job, JobCounter* counter)
+{
+	QueueJob(nullptr, std::move(job), counter, false);
+}
+
+void RunJobAfter(JobCounter* dependency, Job job, JobCounter* counter)
+{
+	QueueJob(dependency, std::move(job), counter, false);
+}
+
+void RunOnMainThreadAfter(JobCounter* dependency, Job job, JobCounter* counter)
+{
+	QueueJob(dependency, std::move(job), counter, true);
+}
+
+void RunMainThreadJobs()
+{
+	//Jobs queued by these run next time
+	std::vector<PendingJob> jobs;
+
+	{
+		std::lock_guard<std::mutex> lock(mainJobsLock);
+		jobs.swap(mainJobs);
+	}
+
+	for (PendingJob& job : jobs)
+	{
+		Execute(job);
+	}
+}
+
+void WaitForCounter(JobCounter& counter)
+{
+	bool mainThread = std::this_thread::get_id() == mainThreadId;
+	PendingJob job;
+
+	while (counter.remaining > 0)
+	{
+		if (mainThread)
+		{
+			RunMainThreadJobs();
+		}
+
+		if (TakeJob(job))
+		{
+			Execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	//The last job may still be releasing dependents, the counter can only go away once it has let go
+	std::lock_guard<std::mutex> lock(counter.dependentsLock);
+}
+
+void ParallelFor(unsigned int first, unsigned int last, unsigned int minChunk, const std::function<void(unsigned int, unsigned int)>& body)
+{
+	unsigned int count = last > first ? last - first : 0;
+	unsigned int chunkCount = std::min(GetJobThreadCount() * JOB_CHUNKS_PER_THREAD, count / std::max(minChunk, 1u));
+
+	if (chunkCount < 2)
+	{
+		if (count > 0)
+		{
+			body(first, last);
+		}
+
+		return;
+	}
+
+	unsigned int chunkSize = (count + chunkCount - 1) / chunkCount;
+	JobCounter counter;
+
+	for (unsigned int chunkFirst = first + chunkSize; chunkFirst < last; chunkFirst += chunkSize)
+	{
+		unsigned int chunkLast = std::min(chunkFirst + chunkSize, last);
+		RunJob([&body, chunkFirst, chunkLast] { body(chunkFirst, chunkLast); }, &counter);
+	}
+
+	body(first, first + chunkSize);
+	WaitForCounter(counter);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+typedef std::function<void()> Job;
+
+struct JobCounter;
+
+struct PendingJob
+{
+	Job job;
+	JobCounter* counter;
+	bool mainThread;
+};
+
+//Jobs still to finish. Waiting on a counter, or on jobs queued after it, holds until it is back to zero.
+//A counter has to outlive the jobs it counts.
+struct JobCounter
+{
+	std::atomic<int> remaining{ 0 };
+	//Jobs held back until this counter is done
+	std::mutex dependentsLock;
+	std::vector<PendingJob> dependents;
+};
+
+//Every thread has its own queue it pushes to and pops from, idle threads steal the oldest jobs of the others.
+//The thread that initializes the system is the main thread, GL jobs are kept for it alone.
+//workerCount of 0 starts one worker per remaining core. Until initialized, or without workers, jobs run as they are queued.
+void InitializeJobs(unsigned int workerCount);
+void ShutdownJobs();
+
+//Keeps the job threads running for as long as it lives, so every way out of main still stops them
+struct JobSystemScope
+{
+	JobSystemScope(unsigned int workerCount) { InitializeJobs(workerCount); }
+	~JobSystemScope() { ShutdownJobs(); }
+};
+//Workers plus the main thread
+unsigned int GetJobThreadCount();
+
+//counter can be null, otherwise it is raised now and lowered once the job has run
+void RunJob(Job job, JobCounter* counter);
+void RunJobAfter(JobCounter* dependency, Job job, JobCounter* counter);
+//For GL calls, run by RunMainThreadJobs or while the main thread waits on a counter. dependency can be null.
+void RunOnMainThreadAfter(JobCounter* dependency, Job job, JobCounter* counter);
+void RunMainThreadJobs();
+
+//Runs other jobs until the counter is back to zero. Only the main thread may wait on main thread jobs.
+void WaitForCounter(JobCounter& counter);
+
+//Runs body over first..last split into chunks of at least minChunk, the calling thread takes a chunk too.
+//Returns once every chunk is done, ranges too small to split run on the calling thread.
+void ParallelFor(unsigned int first, unsigned int last, unsigned int minChunk, const std::function<void(unsigned int, unsigned int)>& body);
\ No newline at end of file
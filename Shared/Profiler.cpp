@@ -0,0 +1,304 @@
+#include <glad.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include "Profiler.h"
+
+using Clock = std::chrono::steady_clock;
+
+//Times are nanoseconds since the profiler started
+struct ProfileEvent
+{
+	const char* name;
+	long long start;
+	long long end;
+};
+
+struct OpenScope
+{
+	const char* name;
+	long long start;
+};
+
+//Written by its own thread, read when a trace is written
+struct ProfileRing
+{
+	std::mutex lock;
+	std::vector<ProfileEvent> events;
+	unsigned long long written;
+	//Thread id in the trace, the GPU is 0
+	unsigned int thread;
+	std::string threadName;
+	bool inUse;
+};
+
+//Hands the ring back when its thread exits, the next new thread takes it over instead of adding another
+struct ThreadRingOwner
+{
+	ProfileRing* ring = nullptr;
+	~ThreadRingOwner();
+};
+
+struct GpuScope
+{
+	const char* name;
+	bool ended;
+};
+
+static Clock::time_point profilerStart = Clock::now();
+static std::thread::id mainThreadId = std::this_thread::get_id();
+
+static std::mutex ringsLock;
+static std::vector<std::unique_ptr<ProfileRing>> rings;
+static thread_local ThreadRingOwner threadRing;
+static thread_local std::vector<OpenScope> openScopes;
+
+//Two timestamp queries per scope, the ring of scopes runs from gpuFirst for gpuCount
+static bool gpuProfilerReady = false;
+static unsigned int gpuQueries[PROFILER_GPU_SCOPES * 2];
+static GpuScope gpuScopes[PROFILER_GPU_SCOPES];
+static unsigned int gpuFirst = 0;
+static unsigned int gpuCount = 0;
+//Scopes begun and not yet ended, -1 for ones that were dropped
+static std::vector<int> gpuOpen;
+static ProfileRing gpuRing;
+//Added to GPU timestamps to put them on the CPU timeline
+static long long gpuOffset = 0;
+
+static long long ProfilerNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - profilerStart).count();
+}
+
+static void PushEvent(ProfileRing& ring, const ProfileEvent& event)
+{
+	std::lock_guard<std::mutex> lock(ring.lock);
+	ring.events[ring.written % PROFILER_RING_SIZE] = event;
+	ring.written++;
+}
+
+ThreadRingOwner::~ThreadRingOwner()
+{
+	if (ring)
+	{
+		std::lock_guard<std::mutex> lock(ringsLock);
+		ring->inUse = false;
+	}
+}
+
+static ProfileRing& GetThreadRing()
+{
+	if (!threadRing.ring)
+	{
+		std::lock_guard<std::mutex> lock(ringsLock);
+		bool mainThread = std::this_thread::get_id() == mainThreadId;
+
+		//Short lived threads, like shader loads, share the rings of ones that have exited
+		for (std::unique_ptr<ProfileRing>& ring : rings)
+		{
+			if (!ring->inUse && !mainThread)
+			{
+				threadRing.ring = ring.get();
+				break;
+			}
+		}
+
+		if (!threadRing.ring)
+		{
+			rings.push_back(std::make_unique<ProfileRing>());
+			threadRing.ring = rings.back().get();
+			threadRing.ring->events.resize(PROFILER_RING_SIZE);
+			threadRing.ring->written = 0;
+			threadRing.ring->thread = (unsigned int)rings.size();
+			threadRing.ring->threadName = mainThread ? "Main thread" : "Thread " + std::to_string(threadRing.ring->thread);
+		}
+
+		threadRing.ring->inUse = true;
+	}
+
+	return *threadRing.ring;
+}
+
+void BeginCpuScope(const char* name)
+{
+	openScopes.push_back({ name, ProfilerNow() });
+}
+
+void EndCpuScope()
+{
+	if (openScopes.empty())
+	{
+		return;
+	}
+
+	OpenScope scope = openScopes.back();
+	openScopes.pop_back();
+	PushEvent(GetThreadRing(), { scope.name, scope.start, ProfilerNow() });
+}
+
+void InitializeGpuProfiler()
+{
+	glGenQueries(PROFILER_GPU_SCOPES * 2, gpuQueries);
+	gpuRing.events.resize(PROFILER_RING_SIZE);
+	gpuRing.written = 0;
+	gpuRing.thread = 0;
+	gpuRing.threadName = "GPU";
+	gpuFirst = 0;
+	gpuCount = 0;
+	gpuOpen.clear();
+	gpuProfilerReady = true;
+	UpdateGpuProfiler();
+}
+
+void CleanupGpuProfiler()
+{
+	if (gpuProfilerReady)
+	{
+		glDeleteQueries(PROFILER_GPU_SCOPES * 2, gpuQueries);
+		gpuProfilerReady = false;
+	}
+}
+
+void BeginGpuScope(const char* name)
+{
+	if (!gpuProfilerReady || gpuCount == PROFILER_GPU_SCOPES)
+	{
+		gpuOpen.push_back(-1);
+		return;
+	}
+
+	unsigned int scope = (gpuFirst + gpuCount) % PROFILER_GPU_SCOPES;
+	gpuCount++;
+	gpuScopes[scope] = { name, false };
+	glQueryCounter(gpuQueries[scope * 2], GL_TIMESTAMP);
+	gpuOpen.push_back((int)scope);
+}
+
+void EndGpuScope()
+{
+	if (gpuOpen.empty())
+	{
+		return;
+	}
+
+	int scope = gpuOpen.back();
+	gpuOpen.pop_back();
+
+	if (scope != -1)
+	{
+		glQueryCounter(gpuQueries[scope * 2 + 1], GL_TIMESTAMP);
+		gpuScopes[scope].ended = true;
+	}
+}
+
+void UpdateGpuProfiler()
+{
+	if (!gpuProfilerReady)
+	{
+		return;
+	}
+
+	//The GPU clock drifts from the CPU one, so the offset is taken again every frame
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	gpuOffset = ProfilerNow() - gpuNow;
+
+	//Scopes finish in the order they were begun apart from nesting, so stop at the first one still out
+	while (gpuCount > 0 && gpuScopes[gpuFirst].ended)
+	{
+		int available = GL_FALSE;
+		glGetQueryObjectiv(gpuQueries[gpuFirst * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available)
+		{
+			break;
+		}
+
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(gpuQueries[gpuFirst * 2], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(gpuQueries[gpuFirst * 2 + 1], GL_QUERY_RESULT, &end);
+		PushEvent(gpuRing, { gpuScopes[gpuFirst].name, (long long)start + gpuOffset, (long long)end + gpuOffset });
+
+		gpuFirst = (gpuFirst + 1) % PROFILER_GPU_SCOPES;
+		gpuCount--;
+	}
+}
+
+static void WriteJsonString(std::ofstream& file, const char* text)
+{
+	file << '"';
+
+	for (; *text; text++)
+	{
+		if (*text == '"' || *text == '\\')
+		{
+			file << '\\';
+		}
+
+		file << *text;
+	}
+
+	file << '"';
+}
+
+//Chrome trace times are microseconds
+static void WriteRing(std::ofstream& file, ProfileRing& ring, bool& first, unsigned int& eventCount)
+{
+	std::lock_guard<std::mutex> lock(ring.lock);
+
+	file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring.thread << ",\"args\":{\"name\":";
+	WriteJsonString(file, ring.threadName.c_str());
+	file << "}}";
+	first = false;
+
+	unsigned long long oldest = ring.written > PROFILER_RING_SIZE ? ring.written - PROFILER_RING_SIZE : 0;
+
+	for (unsigned long long i = oldest; i < ring.written; i++)
+	{
+		const ProfileEvent& event = ring.events[i % PROFILER_RING_SIZE];
+		file << ",\n{\"name\":";
+		WriteJsonString(file, event.name);
+		file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.thread << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+		eventCount++;
+	}
+}
+
+bool WriteProfilerTrace(const char* path)
+{
+	std::ofstream file(path);
+
+	if (!file)
+	{
+		std::cout << "Couldn't write profiler trace " << path << "\n";
+		return false;
+	}
+
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	file << "{\"traceEvents\":[";
+	bool first = true;
+	unsigned int eventCount = 0;
+
+	if (gpuProfilerReady)
+	{
+		WriteRing(file, gpuRing, first, eventCount);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(ringsLock);
+
+		for (std::unique_ptr<ProfileRing>& ring : rings)
+		{
+			WriteRing(file, *ring, first, eventCount);
+		}
+	}
+
+	file << "\n]}\n";
+	std::cout << "Wrote profiler trace " << path << " with " << eventCount << " events\n";
+	return true;
+}
\ No newline at end of file
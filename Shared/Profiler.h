@@ -0,0 +1,42 @@
+#pragma once
+
+//Scoped timings from every thread and from the GPU, kept in ring buffers and written out as Chrome trace JSON
+//for chrome://tracing or Perfetto. Scope names are kept as pointers, so they have to be string literals.
+
+//Events kept per thread and for the GPU, the oldest are overwritten first
+#define PROFILER_RING_SIZE 65536
+//GPU scopes waiting on their results, scopes begun past this are dropped until some come back
+#define PROFILER_GPU_SCOPES 1024
+
+void BeginCpuScope(const char* name);
+void EndCpuScope();
+
+//GPU scopes nest like CPU ones and need a GL context. Results are only read once the GPU has them,
+//a few frames late, so the CPU never waits on a query.
+void InitializeGpuProfiler();
+void CleanupGpuProfiler();
+void BeginGpuScope(const char* name);
+void EndGpuScope();
+//Collects the GPU scopes that have finished, once per frame
+void UpdateGpuProfiler();
+
+//Writes whatever the ring buffers hold, false if the file can't be written
+bool WriteProfilerTrace(const char* path);
+
+struct CpuProfileScope
+{
+	CpuProfileScope(const char* name) { BeginCpuScope(name); }
+	~CpuProfileScope() { EndCpuScope(); }
+};
+
+struct GpuProfileScope
+{
+	GpuProfileScope(const char* name) { BeginGpuScope(name); }
+	~GpuProfileScope() { EndGpuScope(); }
+};
+
+#define PROFILER_JOIN_NAME(a, b) a##b
+#define PROFILER_SCOPE_NAME(a, b) PROFILER_JOIN_NAME(a, b)
+//Times the rest of the enclosing block
+#define PROFILE_SCOPE(name) CpuProfileScope PROFILER_SCOPE_NAME(cpuProfileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILER_SCOPE_NAME(gpuProfileScope, __LINE__)(name)
\ No newline at end of file
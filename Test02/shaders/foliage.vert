@@ -4,8 +4,8 @@
 layout (location = 0) in vec3 in_pos;
 layout (location = 1) in vec3 in_normal;
 layout (location = 2) in vec2 in_uv;
+#include "include/node_transform.glsl"
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -16,10 +16,11 @@ out vec3 vert_worldPos;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(in_pos, 1.0);
+	vec3 worldPos = TransformPosition(in_pos);
+	gl_Position = projection * view * vec4(worldPos, 1.0);
 	//gl_Position = view * model * vec4(in_pos, 1.0);
 
 	vert_uv = in_uv;
-	vert_normal = mat3(transpose(inverse(model))) * in_normal;
-	vert_worldPos = vec3(model * vec4(in_pos, 1.0));
+	vert_normal = TransformNormal(in_normal);
+	vert_worldPos = worldPos;
 }
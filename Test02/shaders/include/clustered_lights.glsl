@@ -0,0 +1,60 @@
+//The LightManager lights binned into this fragment's cluster
+#include "surface.glsl"
+
+uniform mat4 view;
+
+//See LightManager.h, the grid size has to match LIGHT_CLUSTERS_*
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
+
+//4 texels per light: position and radius, color and intensity, direction and type, spot cone cosines
+uniform samplerBuffer lightData;
+//Offset and count into lightIndices for every cluster
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer lightIndices;
+//Size of a screen tile in pixels, and the scale and bias turning log(depth) into a slice
+uniform vec2 clusterTileSize;
+uniform vec2 clusterDepth;
+
+vec3 CalcClusterLight(Surface surface, int light)
+{
+	vec4 positionRadius = texelFetch(lightData, light * 4);
+	vec4 colorIntensity = texelFetch(lightData, light * 4 + 1);
+	vec4 directionType = texelFetch(lightData, light * 4 + 2);
+	vec4 cone = texelFetch(lightData, light * 4 + 3);
+
+	//Inverse square falloff, windowed so it reaches zero at the light's radius
+	vec3 toLight = positionRadius.xyz - surface.position;
+	float lightDistance = length(toLight);
+	float window = clamp(1.0 - pow(lightDistance / positionRadius.w, 4.0), 0.0, 1.0);
+	float attenuation = colorIntensity.w * window * window / (lightDistance * lightDistance + 1.0);
+	vec3 lightDir = toLight / max(lightDistance, 0.0001);
+
+	//Spot lights fade out between the inner and outer cone
+	if (directionType.w > 0.5)
+	{
+		float theta = dot(-lightDir, directionType.xyz);
+		attenuation *= clamp((theta - cone.y) / max(cone.x - cone.y, 0.0001), 0.0, 1.0);
+	}
+
+	return Shade(surface, lightDir, colorIntensity.rgb * attenuation, colorIntensity.rgb * attenuation);
+}
+
+vec3 CalcClusterLights(Surface surface)
+{
+	//Find this fragment's cluster and only evaluate the lights binned into it
+	float depth = -(view * vec4(surface.position, 1.0)).z;
+	int slice = clamp(int(floor(log(depth) * clusterDepth.x + clusterDepth.y)), 0, LIGHT_CLUSTERS_Z - 1);
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0), ivec2(LIGHT_CLUSTERS_X - 1, LIGHT_CLUSTERS_Y - 1));
+	uvec2 range = texelFetch(clusterGrid, (slice * LIGHT_CLUSTERS_Y + tile.y) * LIGHT_CLUSTERS_X + tile.x).xy;
+	vec3 lighting = vec3(0.0);
+
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+		lighting += CalcClusterLight(surface, light);
+	}
+
+	return lighting;
+}
@@ -0,0 +1,17 @@
+//The dirLight uniforms, set by ApplyLightClusters
+#include "surface.glsl"
+
+struct DirLight
+{
+	vec3 direction;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+uniform DirLight dirLight;
+
+vec3 CalcDirLight(Surface surface)
+{
+	vec3 lightDir = normalize(-dirLight.direction);
+	return dirLight.ambient * surface.albedo + Shade(surface, lightDir, dirLight.diffuse, dirLight.specular);
+}
@@ -0,0 +1,6 @@
+//Fades to white with distance from the camera
+float FogAmount()
+{
+	//w is the view depth for any perspective projection, so this holds for standard and reversed depth alike
+	return (1.0 / gl_FragCoord.w) / 25;
+}
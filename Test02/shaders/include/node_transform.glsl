@@ -0,0 +1,19 @@
+//Places vertices of a model node instance in the world, the node transform first then the model one
+//Transform of the model node this instance is drawn at, see Model.cpp for the instance buffer
+layout (location = 3) in mat3x4 in_node;
+layout (location = 6) in mat3 in_nodeNormal;
+
+//Affine transforms are their top three rows, a point times one gives the transformed point
+uniform mat3x4 model;
+//Inverse transpose of the model transform, worked out on the CPU like the node ones
+uniform mat3 modelNormal;
+
+vec3 TransformPosition(vec3 pos)
+{
+	return vec4(vec4(pos, 1.0) * in_node, 1.0) * model;
+}
+
+vec3 TransformNormal(vec3 normal)
+{
+	return modelNormal * (in_nodeNormal * normal);
+}
@@ -0,0 +1,36 @@
+//The single light set with SetLightPosition, narrowed to a cone with SetLightSpot when SPOT_LIGHT is defined
+#include "surface.glsl"
+
+struct Light
+{
+	vec3 position;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+	float attenConstant;
+	float attenLinear;
+	float attenQuadratic;
+#ifdef SPOT_LIGHT
+	vec3 direction;
+	float cutoff;
+	float cutoffInner;
+#endif
+};
+uniform Light light;
+
+vec3 CalcPointLight(Surface surface)
+{
+	float lightDistance = length(light.position - surface.position);
+	float attenuation = 1.0 / (light.attenConstant + light.attenLinear * lightDistance + 
+				light.attenQuadratic * (lightDistance * lightDistance));
+	vec3 lightDir = normalize(light.position - surface.position);
+
+	//Ambient is left out of the cone so the area around a spot isn't pitch black
+	float spot = 1.0;
+#ifdef SPOT_LIGHT
+	float theta = dot(lightDir, normalize(-light.direction));
+	spot = clamp((theta - light.cutoff) / (light.cutoffInner - light.cutoff), 0.0, 1.0);
+#endif
+
+	return attenuation * (light.ambient * surface.albedo + spot * Shade(surface, lightDir, light.diffuse, light.specular));
+}
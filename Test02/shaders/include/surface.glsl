@@ -0,0 +1,51 @@
+//Material inputs, sampled once per fragment and shared by every light
+
+//Input from Vert Shader
+in vec2 vert_uv;
+in vec3 vert_normal;
+in vec3 vert_worldPos;
+
+uniform vec3 viewPos;
+
+struct Material
+{
+	sampler2D texture_diffuse1;
+	sampler2D texture_specular1;
+	float shininess;
+};
+uniform Material material;
+
+struct Surface
+{
+	vec3 position;
+	vec3 normal;
+	vec3 viewDir;
+	vec3 albedo;
+	float alpha;
+	vec3 specular;
+	float shininess;
+};
+
+Surface FetchSurface()
+{
+	vec4 diffuseSample = texture(material.texture_diffuse1, vert_uv);
+
+	Surface surface;
+	surface.position = vert_worldPos;
+	surface.normal = normalize(vert_normal);
+	surface.viewDir = normalize(viewPos - vert_worldPos);
+	surface.albedo = diffuseSample.rgb;
+	surface.alpha = diffuseSample.a;
+	surface.specular = texture(material.texture_specular1, vert_uv).xyz;
+	surface.shininess = material.shininess;
+	return surface;
+}
+
+//Diffuse and specular from a light arriving along lightDir
+vec3 Shade(Surface surface, vec3 lightDir, vec3 diffuseColor, vec3 specularColor)
+{
+	float litAmount = max(dot(surface.normal, lightDir), 0.0);
+	vec3 reflectDir = reflect(-lightDir, surface.normal);
+	float specAmount = pow(max(dot(surface.viewDir, reflectDir), 0.0), surface.shininess);
+	return diffuseColor * litAmount * surface.albedo + specularColor * specAmount * surface.specular;
+}
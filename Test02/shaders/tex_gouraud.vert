@@ -4,8 +4,8 @@
 layout (location = 0) in vec3 in_pos;
 layout (location = 1) in vec3 in_normal;
 layout (location = 2) in vec2 in_uv;
+#include "include/node_transform.glsl"
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform vec3 color;
@@ -23,8 +23,8 @@ void main()
 	vec3 ambient = lightColor * 0.6;
 
 	//Calculate diffuse
-	vec3 normal = mat3(transpose(inverse(model))) * normalize(in_normal);
-	vec3 worldPos = vec3(model * vec4(in_pos, 1.0));
+	vec3 normal = TransformNormal(normalize(in_normal));
+	vec3 worldPos = TransformPosition(in_pos);
 	vec3 lightDir = normalize(lightPos - worldPos);
 	float litAmount = max(dot(normal, lightDir), 0);
 	vec3 diffuse = litAmount * lightColor * 2;
@@ -39,5 +39,5 @@ void main()
 	vert_color = color * (ambient + diffuse + specular);
 	vert_uv = in_uv;
 
-	gl_Position = projection * view * model * vec4(in_pos, 1.0);
+	gl_Position = projection * view * vec4(worldPos, 1.0);
 }
@@ -5,7 +5,7 @@ layout (location = 0) in vec3 in_pos;
 layout (location = 1) in vec3 in_normal;
 layout (location = 2) in vec2 in_uv;
 
-uniform mat4 model;
+uniform mat3x4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
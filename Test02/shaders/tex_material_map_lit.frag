@@ -0,0 +1,55 @@
+#version 330 core
+
+//One source for every lit material shader, each program defines some of:
+//DIRECTIONAL_LIGHT - the dirLight uniforms
+//POINT_LIGHT - the single light set with SetLightPosition
+//SPOT_LIGHT - the single light narrowed to a cone with SetLightSpot
+//CLUSTERED_LIGHTS - the LightManager lights binned into this fragment's cluster
+//FOG - fades to white with distance
+
+#ifdef SPOT_LIGHT
+#define POINT_LIGHT
+#endif
+
+#include "include/surface.glsl"
+
+#ifdef DIRECTIONAL_LIGHT
+#include "include/directional_light.glsl"
+#endif
+
+#ifdef POINT_LIGHT
+#include "include/point_light.glsl"
+#endif
+
+#ifdef CLUSTERED_LIGHTS
+#include "include/clustered_lights.glsl"
+#endif
+
+#ifdef FOG
+#include "include/fog.glsl"
+#endif
+
+//Output
+out vec4 frag_color;
+
+void main()
+{
+	Surface surface = FetchSurface();
+	vec3 lighting = vec3(0.0);
+
+#ifdef DIRECTIONAL_LIGHT
+	lighting += CalcDirLight(surface);
+#endif
+#ifdef POINT_LIGHT
+	lighting += CalcPointLight(surface);
+#endif
+#ifdef CLUSTERED_LIGHTS
+	lighting += CalcClusterLights(surface);
+#endif
+
+	frag_color = vec4(lighting, 1.0);
+
+#ifdef FOG
+	frag_color = mix(frag_color, vec4(1), FogAmount());
+#endif
+}
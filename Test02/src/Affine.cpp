@@ -0,0 +1,161 @@
+#include "Affine.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AFFINE_USE_SSE
+#endif
+
+using glm::vec3;
+using glm::vec4;
+using glm::mat4;
+
+Affine IdentityAffine()
+{
+	return { { vec4(1.f, 0.f, 0.f, 0.f), vec4(0.f, 1.f, 0.f, 0.f), vec4(0.f, 0.f, 1.f, 0.f) } };
+}
+
+Affine AffineFromMatrix(const glm::mat4& matrix)
+{
+	mat4 transposed = glm::transpose(matrix);
+	return { { transposed[0], transposed[1], transposed[2] } };
+}
+
+glm::mat4 AffineToMatrix(const Affine& affine)
+{
+	return glm::transpose(mat4(affine.rows[0], affine.rows[1], affine.rows[2], vec4(0.f, 0.f, 0.f, 1.f)));
+}
+
+#ifdef AFFINE_USE_SSE
+#define SPLAT(v, lane) _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane))
+
+//Each row of the result is the parent row's weights over the child rows, plus the parent's translation
+Affine ComposeAffine(const Affine& parent, const Affine& child)
+{
+	__m128 childRows[3] = { _mm_loadu_ps(&child.rows[0].x), _mm_loadu_ps(&child.rows[1].x), _mm_loadu_ps(&child.rows[2].x) };
+	__m128 translationMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+	Affine result;
+
+	for (int row = 0; row < 3; row++)
+	{
+		__m128 weights = _mm_loadu_ps(&parent.rows[row].x);
+		__m128 sum = _mm_and_ps(weights, translationMask);
+		sum = _mm_add_ps(sum, _mm_mul_ps(SPLAT(weights, 0), childRows[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(SPLAT(weights, 1), childRows[1]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(SPLAT(weights, 2), childRows[2]));
+		_mm_storeu_ps(&result.rows[row].x, sum);
+	}
+
+	return result;
+}
+
+//Cross product of the xyz lanes, w comes out as zero
+static __m128 Cross(__m128 a, __m128 b)
+{
+	__m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+//The columns of the inverse are the cross products of the rows over the determinant,
+//the translation is the original one taken back through them
+Affine InvertAffine(const Affine& affine)
+{
+	__m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 row0 = _mm_loadu_ps(&affine.rows[0].x);
+	__m128 row1 = _mm_loadu_ps(&affine.rows[1].x);
+	__m128 row2 = _mm_loadu_ps(&affine.rows[2].x);
+	__m128 linear0 = _mm_and_ps(row0, xyzMask);
+	__m128 linear1 = _mm_and_ps(row1, xyzMask);
+	__m128 linear2 = _mm_and_ps(row2, xyzMask);
+
+	__m128 column0 = Cross(linear1, linear2);
+	__m128 column1 = Cross(linear2, linear0);
+	__m128 column2 = Cross(linear0, linear1);
+
+	//Determinant is row 0 dotted with its cofactors, summed across the lanes
+	__m128 products = _mm_mul_ps(linear0, column0);
+	__m128 determinant = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+	determinant = _mm_add_ps(determinant, _mm_shuffle_ps(determinant, determinant, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.f), determinant);
+
+	column0 = _mm_mul_ps(column0, inverseDeterminant);
+	column1 = _mm_mul_ps(column1, inverseDeterminant);
+	column2 = _mm_mul_ps(column2, inverseDeterminant);
+
+	__m128 translation = _mm_mul_ps(column0, SPLAT(row0, 3));
+	translation = _mm_add_ps(translation, _mm_mul_ps(column1, SPLAT(row1, 3)));
+	translation = _mm_add_ps(translation, _mm_mul_ps(column2, SPLAT(row2, 3)));
+	translation = _mm_sub_ps(_mm_setzero_ps(), translation);
+
+	_MM_TRANSPOSE4_PS(column0, column1, column2, translation);
+
+	Affine result;
+	_mm_storeu_ps(&result.rows[0].x, column0);
+	_mm_storeu_ps(&result.rows[1].x, column1);
+	_mm_storeu_ps(&result.rows[2].x, column2);
+	return result;
+}
+#else
+Affine ComposeAffine(const Affine& parent, const Affine& child)
+{
+	Affine result;
+
+	for (int row = 0; row < 3; row++)
+	{
+		vec4 weights = parent.rows[row];
+		result.rows[row] = weights.x * child.rows[0] + weights.y * child.rows[1] + weights.z * child.rows[2] + vec4(0.f, 0.f, 0.f, weights.w);
+	}
+
+	return result;
+}
+
+Affine InvertAffine(const Affine& affine)
+{
+	vec3 row0(affine.rows[0]), row1(affine.rows[1]), row2(affine.rows[2]);
+	vec3 column0 = glm::cross(row1, row2);
+	vec3 column1 = glm::cross(row2, row0);
+	vec3 column2 = glm::cross(row0, row1);
+	float inverseDeterminant = 1.f / glm::dot(row0, column0);
+	column0 *= inverseDeterminant;
+	column1 *= inverseDeterminant;
+	column2 *= inverseDeterminant;
+	vec3 translation = -(column0 * affine.rows[0].w + column1 * affine.rows[1].w + column2 * affine.rows[2].w);
+
+	Affine result;
+
+	for (int row = 0; row < 3; row++)
+	{
+		result.rows[row] = vec4(column0[row], column1[row], column2[row], translation[row]);
+	}
+
+	return result;
+}
+#endif
+
+//Rows of the inverse transpose are the columns of the inverse, the cross products of the rows
+glm::mat3 GetNormalMatrix(const Affine& affine)
+{
+	vec3 row0(affine.rows[0]), row1(affine.rows[1]), row2(affine.rows[2]);
+	vec3 cofactors0 = glm::cross(row1, row2);
+	float inverseDeterminant = 1.f / glm::dot(row0, cofactors0);
+	return glm::transpose(glm::mat3(cofactors0, glm::cross(row2, row0), glm::cross(row0, row1))) * inverseDeterminant;
+}
+
+//Scale times rotation inverse transposes to the rotation over the scale, which is the linear part over the squared scale
+glm::mat3 GetUniformScaleNormalMatrix(const Affine& affine)
+{
+	vec3 row0(affine.rows[0]), row1(affine.rows[1]), row2(affine.rows[2]);
+	return glm::transpose(glm::mat3(row0, row1, row2)) * (1.f / glm::dot(row0, row0));
+}
+
+glm::vec3 TransformAffinePoint(const Affine& affine, glm::vec3 point)
+{
+	vec4 homogeneous(point, 1.f);
+	return vec3(glm::dot(affine.rows[0], homogeneous), glm::dot(affine.rows[1], homogeneous), glm::dot(affine.rows[2], homogeneous));
+}
+
+glm::vec3 GetAffinePosition(const Affine& affine)
+{
+	return vec3(affine.rows[0].w, affine.rows[1].w, affine.rows[2].w);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+//Affine transform stored as the top three rows of its 4x4 matrix, the bottom row is always 0 0 0 1.
+//48 bytes against the 64 of a mat4, and the layout shaders read as a mat3x4 where a point times the matrix
+//gives the transformed point, for uniforms, instance attributes and buffers alike.
+struct Affine
+{
+	glm::vec4 rows[3];
+};
+
+static_assert(sizeof(Affine) == 12 * sizeof(float), "Affine must stay tightly packed for uploads");
+
+Affine IdentityAffine();
+Affine AffineFromMatrix(const glm::mat4& matrix);
+glm::mat4 AffineToMatrix(const Affine& affine);
+
+//parent * child, applies child first
+Affine ComposeAffine(const Affine& parent, const Affine& child);
+//Inverse of a non singular transform, the linear part is inverted in full so shear and non uniform scale work
+Affine InvertAffine(const Affine& affine);
+
+//Inverse transpose of the linear part, what normals are transformed by
+glm::mat3 GetNormalMatrix(const Affine& affine);
+//The same when every axis is scaled alike, the linear part over the squared scale without an inverse
+glm::mat3 GetUniformScaleNormalMatrix(const Affine& affine);
+
+glm::vec3 TransformAffinePoint(const Affine& affine, glm::vec3 point);
+glm::vec3 GetAffinePosition(const Affine& affine);
\ No newline at end of file
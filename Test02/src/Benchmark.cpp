@@ -0,0 +1,476 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "Benchmark.h"
+#include "LightManager.h"
+#include "Camera.h"
+#include "Transform.h"
+#include "TransformBatch.h"
+#include "Affine.h"
+#include "glm/gtc/quaternion.hpp"
+#include "glm/gtx/euler_angles.hpp"
+
+using glm::vec3;
+using glm::vec4;
+using glm::mat4;
+using Clock = std::chrono::high_resolution_clock;
+
+//Results of timed loops that have no other side effects are written here so they aren't optimized away
+static volatile float benchmarkSink;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+//Random points in front of the camera, any light reaching a point has to be in that point's cluster
+static unsigned int CountMissedLights(const std::vector<vec4>& lights, const mat4& view, const mat4& projection, float near, float far)
+{
+	std::mt19937 random(lights.size());
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	unsigned int missed = 0;
+
+	for (int i = 0; i < 10000; i++)
+	{
+		//Pick a pixel and a depth, then walk back to view space
+		float ndcX = unit(random) * 2.f - 1.f;
+		float ndcY = unit(random) * 2.f - 1.f;
+		float depth = near * std::pow(far / near, unit(random));
+		vec3 viewPoint(ndcX * depth / projection[0][0], ndcY * depth / projection[1][1], -depth);
+		vec3 worldPoint = vec3(glm::inverse(view) * vec4(viewPoint, 1.f));
+
+		int slice = std::min((int)(std::log(depth / near) / std::log(far / near) * LIGHT_CLUSTERS_Z), LIGHT_CLUSTERS_Z - 1);
+		int tileX = std::min((int)((ndcX * 0.5f + 0.5f) * LIGHT_CLUSTERS_X), LIGHT_CLUSTERS_X - 1);
+		int tileY = std::min((int)((ndcY * 0.5f + 0.5f) * LIGHT_CLUSTERS_Y), LIGHT_CLUSTERS_Y - 1);
+
+		const unsigned int* binned = GetClusterLights(tileX, tileY, slice);
+		unsigned int binnedCount = GetClusterLightCount(tileX, tileY, slice);
+
+		for (unsigned int light = 0; light < lights.size(); light++)
+		{
+			if (glm::length(vec3(lights[light]) - worldPoint) < lights[light].w && std::find(binned, binned + binnedCount, light) == binned + binnedCount)
+			{
+				missed++;
+			}
+		}
+	}
+
+	return missed;
+}
+
+static void BenchmarkLightClusters(unsigned int lightCount, int runs)
+{
+	std::mt19937 random(lightCount);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<vec4> lights(lightCount);
+
+	ClearLights();
+
+	//Spread through a sponza sized volume
+	for (vec4& light : lights)
+	{
+		light = vec4(unit(random) * 28.f - 14.f, unit(random) * 4.f, unit(random) * 14.f - 7.f, 1.5f + unit(random) * 1.5f);
+		AddPointLight(vec3(light), light.w, vec3(1.f), 1.f);
+	}
+
+	mat4 view = glm::lookAt(vec3(-12.f, 2.f, 0.f), vec3(0.f, 1.5f, 0.f), vec3(0.f, 1.f, 0.f));
+	mat4 projection = glm::perspective(glm::radians(75.f), 1440.f / 1080.f, 0.1f, 50.f);
+	double best = 0.0;
+
+	for (int i = 0; i < runs; i++)
+	{
+		Clock::time_point start = Clock::now();
+		BuildLightClusters(view, projection, 0.1f, 50.f, 1440, 1080);
+		double time = MillisecondsSince(start);
+
+		if (i == 0 || time < best)
+		{
+			best = time;
+		}
+	}
+
+	//Average light list length over the clusters that have any
+	unsigned int usedClusters = 0;
+	unsigned int binnedLights = 0;
+
+	for (unsigned int z = 0; z < LIGHT_CLUSTERS_Z; z++)
+	{
+		for (unsigned int y = 0; y < LIGHT_CLUSTERS_Y; y++)
+		{
+			for (unsigned int x = 0; x < LIGHT_CLUSTERS_X; x++)
+			{
+				unsigned int count = GetClusterLightCount(x, y, z);
+				usedClusters += count > 0 ? 1 : 0;
+				binnedLights += count;
+			}
+		}
+	}
+
+	unsigned int missed = CountMissedLights(lights, view, projection, 0.1f, 50.f);
+
+	std::cout << "Light clusters " << lightCount << " lights: " << best << " ms, " << (usedClusters > 0 ? (float)binnedLights / usedClusters : 0.f)
+		<< " lights per used cluster, " << missed << " missed\n";
+}
+
+//Every instance reads the view and projection once per frame, the camera moves once per frame
+static void BenchmarkCamera(unsigned int instanceCount, int frames)
+{
+	Camera camera;
+	camera.SetFOV(75.f);
+	camera.SetNearFar(0.1f, 50.f);
+	camera.SetViewport(1440, 1080);
+	mat4 sum(0.f);
+
+	Clock::time_point start = Clock::now();
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		//Read per instance, like a draw asking the camera, so the rebuild can't be hoisted out of the loop
+		volatile float cameraX = frame * 0.01f;
+		volatile float fov = 75.f;
+		vec3 forward(0.f, 0.f, -1.f);
+
+		for (unsigned int i = 0; i < instanceCount; i++)
+		{
+			vec3 position(cameraX, 1.f, 2.f);
+			sum += glm::lookAt(position, position + forward, vec3(0.f, 1.f, 0.f));
+			sum += glm::perspective(glm::radians(fov), 1440.f / 1080.f, 0.1f, 50.f);
+		}
+	}
+
+	double rebuilt = MillisecondsSince(start);
+	start = Clock::now();
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		camera.SetPosition(vec3(frame * 0.01f, 1.f, 2.f));
+
+		for (unsigned int i = 0; i < instanceCount; i++)
+		{
+			sum += camera.GetView();
+			sum += camera.GetProjection();
+		}
+	}
+
+	double cached = MillisecondsSince(start);
+	benchmarkSink = sum[0][0];
+
+	//Spheres the planes reject must have every point outside clip space
+	std::mt19937 random(instanceCount);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	unsigned int wrong = 0;
+
+	for (int i = 0; i < 10000; i++)
+	{
+		vec3 point(unit(random) * 60.f - 30.f, unit(random) * 60.f - 30.f, unit(random) * 60.f - 30.f);
+		vec4 clip = camera.GetViewProjection() * vec4(point, 1.f);
+		bool inside = std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && std::abs(clip.z) <= clip.w;
+		wrong += inside != camera.IsSphereVisible(point, 0.f) ? 1 : 0;
+	}
+
+	std::cout << "Camera " << instanceCount << " instances: rebuilt " << rebuilt / frames << " ms, cached " << cached / frames
+		<< " ms per frame, " << wrong << " wrong frustum tests\n";
+}
+
+//Largest difference between an affine transform and the top three rows of the reference
+static float AffineError(const Affine& affine, const mat4& reference)
+{
+	float error = 0.f;
+
+	for (int row = 0; row < 3; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			error = std::max(error, std::abs(affine.rows[row][column] - reference[column][row]));
+		}
+	}
+
+	return error;
+}
+
+//Local matrices one at a time through glm against the SSE batch, for euler angles and quaternions
+static void BenchmarkTransformBuilder(unsigned int count, int runs)
+{
+	std::mt19937 random(count);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<float> components[11];
+
+	for (std::vector<float>& component : components)
+	{
+		component.resize(count);
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		glm::quat rotation = glm::normalize(glm::quat(unit(random) * 2.f - 1.f, unit(random) * 2.f - 1.f, unit(random) * 2.f - 1.f, unit(random) * 2.f - 1.f));
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			components[axis][i] = unit(random) * 200.f - 100.f;
+			components[3 + axis][i] = unit(random) * 720.f - 360.f;
+			components[6 + axis][i] = 0.1f + unit(random) * 2.f;
+		}
+
+		components[9][i] = rotation.x;
+		components[10][i] = rotation.y;
+		components[3][i] = rotation.z;
+		components[4][i] = rotation.w;
+	}
+
+	//Euler reads x, y, z from 3 to 5, quaternions reuse 3 and 4 for z and w
+	TransformArrays euler = { { components[0].data(), components[1].data(), components[2].data() },
+		{ components[3].data(), components[4].data(), components[5].data(), nullptr }, { components[6].data(), components[7].data(), components[8].data() } };
+	TransformArrays quaternion = { { components[0].data(), components[1].data(), components[2].data() },
+		{ components[9].data(), components[10].data(), components[3].data(), components[4].data() }, { components[6].data(), components[7].data(), components[8].data() } };
+
+	std::vector<mat4> reference(count);
+	std::vector<mat4> matrices(count);
+	std::vector<Affine> affines(count);
+	double times[3] = { 0.0, 0.0, 0.0 };
+
+	for (int run = 0; run < runs; run++)
+	{
+		Clock::time_point start = Clock::now();
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			vec3 rotation = glm::radians(vec3(components[3][i], components[4][i], components[5][i]));
+			mat4 local = glm::scale(glm::translate(mat4(1.f), vec3(components[0][i], components[1][i], components[2][i])), vec3(components[6][i], components[7][i], components[8][i]));
+			reference[i] = local * glm::eulerAngleYXZ(rotation.y, rotation.x, rotation.z);
+		}
+
+		times[0] += MillisecondsSince(start);
+		start = Clock::now();
+		BuildTransformMatrices(euler, EulerRotation, nullptr, count, matrices.data());
+		times[1] += MillisecondsSince(start);
+		start = Clock::now();
+		BuildAffineTransforms(euler, EulerRotation, nullptr, count, affines.data());
+		times[2] += MillisecondsSince(start);
+	}
+
+	float eulerError = 0.f;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		eulerError = std::max(eulerError, AffineError(affines[i], reference[i]));
+
+		for (int column = 0; column < 4; column++)
+		{
+			eulerError = std::max(eulerError, glm::length(matrices[i][column] - reference[i][column]));
+		}
+	}
+
+	//Every other element through the index list
+	std::vector<unsigned int> indices;
+
+	for (unsigned int i = 0; i < count; i += 2)
+	{
+		indices.push_back(i);
+	}
+
+	BuildAffineTransforms(quaternion, QuaternionRotation, indices.data(), (unsigned int)indices.size(), affines.data());
+	float quaternionError = 0.f;
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		unsigned int element = indices[i];
+		glm::quat rotation(components[4][element], components[9][element], components[10][element], components[3][element]);
+		mat4 local = glm::scale(glm::translate(mat4(1.f), vec3(components[0][element], components[1][element], components[2][element])), vec3(components[6][element], components[7][element], components[8][element]));
+		quaternionError = std::max(quaternionError, AffineError(affines[i], local * glm::mat4_cast(rotation)));
+	}
+
+	std::cout << "Transform builder " << count << " transforms: glm " << times[0] / runs << " ms, batch 4x4 " << times[1] / runs << " ms, batch 3x4 " << times[2] / runs
+		<< " ms, euler error " << eulerError << ", quaternion error " << quaternionError << "\n";
+}
+
+//Composing and inverting affine transforms against full mat4 products and inverses
+static void BenchmarkAffine(unsigned int count, int runs)
+{
+	std::mt19937 random(count);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<mat4> matrices(count);
+	std::vector<Affine> affines(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		vec3 rotation(unit(random) * 6.28f, unit(random) * 6.28f, unit(random) * 6.28f);
+		mat4 local = glm::scale(glm::translate(mat4(1.f), vec3(unit(random), unit(random), unit(random)) * 200.f - 100.f), vec3(unit(random), unit(random), unit(random)) * 2.f + 0.1f);
+		matrices[i] = local * glm::eulerAngleYXZ(rotation.y, rotation.x, rotation.z);
+		affines[i] = AffineFromMatrix(matrices[i]);
+	}
+
+	std::vector<mat4> matrixResults(count);
+	std::vector<Affine> affineResults(count);
+	double times[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+	for (int run = 0; run < runs; run++)
+	{
+		//Each transform is composed with its neighbour, as a child is with its parent
+		Clock::time_point start = Clock::now();
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			matrixResults[i] = matrices[(i + 1) % count] * matrices[i];
+		}
+
+		times[0] += MillisecondsSince(start);
+		start = Clock::now();
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			affineResults[i] = ComposeAffine(affines[(i + 1) % count], affines[i]);
+		}
+
+		times[1] += MillisecondsSince(start);
+		start = Clock::now();
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			matrixResults[i] = glm::inverse(matrices[i]);
+		}
+
+		times[2] += MillisecondsSince(start);
+		start = Clock::now();
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			affineResults[i] = InvertAffine(affines[i]);
+		}
+
+		times[3] += MillisecondsSince(start);
+	}
+
+	//Inverses are compared last since they are what the final run left behind, products are checked separately
+	float inverseError = 0.f;
+	float composeError = 0.f;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		inverseError = std::max(inverseError, AffineError(affineResults[i], matrixResults[i]));
+		composeError = std::max(composeError, AffineError(ComposeAffine(affines[(i + 1) % count], affines[i]), matrices[(i + 1) % count] * matrices[i]));
+	}
+
+	std::cout << "Affine " << count << " transforms: compose mat4 " << times[0] / runs << " ms, affine " << times[1] / runs << " ms, invert mat4 " << times[2] / runs
+		<< " ms, affine " << times[3] / runs << " ms, compose error " << composeError << ", invert error " << inverseError << "\n";
+}
+
+//World matrix built by walking up the parents, what the hierarchy has to match
+static mat4 WalkToRoot(Transform transform)
+{
+	mat4 world(1.f);
+
+	for (; transform != NO_TRANSFORM; transform = GetTransformParent(transform))
+	{
+		vec3 rotation = glm::radians(GetTransformRotation(transform));
+		mat4 local = glm::scale(glm::translate(mat4(1.f), GetTransformPosition(transform)), GetTransformScale(transform));
+		world = local * glm::eulerAngleYXZ(rotation.y, rotation.x, rotation.z) * world;
+	}
+
+	return world;
+}
+
+//Roots each carry three attachments with two attachments of their own, like props and lights on characters
+static void BenchmarkTransforms(unsigned int rootCount, int frames)
+{
+	std::mt19937 random(rootCount);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<Transform> roots;
+
+	ClearTransforms();
+
+	for (unsigned int i = 0; i < rootCount; i++)
+	{
+		Transform root = CreateTransform(NO_TRANSFORM);
+		SetTransformPosition(root, vec3(unit(random), 0.f, unit(random)) * 100.f);
+		roots.push_back(root);
+
+		for (int j = 0; j < 3; j++)
+		{
+			Transform child = CreateTransform(root);
+			SetTransformPosition(child, vec3(unit(random), unit(random), unit(random)));
+			//The first child keeps uniform scale so both normal matrix paths are covered
+			SetTransformScale(child, vec3(1.f, 1.f + j * 0.5f, 1.f));
+
+			for (int k = 0; k < 2; k++)
+			{
+				Transform grandchild = CreateTransform(child);
+				SetTransformRotation(grandchild, vec3(0.f, unit(random) * 360.f, 0.f));
+				SetTransformScale(grandchild, vec3(0.5f));
+			}
+		}
+	}
+
+	//Nodes created before their parents force a sort, as does moving one under a deeper node
+	SetTransformParent(roots[0], roots[1] + 1);
+	UpdateTransforms();
+
+	double times[3] = { 0.0, 0.0, 0.0 };
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		//Everything moves, a tenth moves, nothing moves
+		for (int pass = 0; pass < 3; pass++)
+		{
+			unsigned int moving = pass == 0 ? rootCount : pass == 1 ? rootCount / 10 : 0;
+
+			for (unsigned int i = 0; i < moving; i++)
+			{
+				SetTransformRotation(roots[(i * 7 + frame) % rootCount], vec3(0.f, frame * 3.f, 0.f));
+			}
+
+			Clock::time_point start = Clock::now();
+			UpdateTransforms();
+			times[pass] += MillisecondsSince(start);
+		}
+	}
+
+	float worstError = 0.f;
+	float worstNormalError = 0.f;
+
+	for (Transform transform = 0; transform < GetTransformCount(); transform++)
+	{
+		mat4 world = WalkToRoot(transform);
+		mat4 difference = world - AffineToMatrix(GetWorldTransform(transform));
+		glm::mat3 normalDifference = glm::transpose(glm::inverse(glm::mat3(world))) - GetWorldNormalMatrix(transform);
+
+		for (int column = 0; column < 4; column++)
+		{
+			worstError = std::max(worstError, glm::length(difference[column]));
+		}
+
+		for (int column = 0; column < 3; column++)
+		{
+			worstNormalError = std::max(worstNormalError, glm::length(normalDifference[column]));
+		}
+	}
+
+	std::cout << "Transforms " << GetTransformCount() << " nodes: all moving " << times[0] / frames * 1000.0 << " us, tenth moving " << times[1] / frames * 1000.0
+		<< " us, none moving " << times[2] / frames * 1000.0 << " us, worst error " << worstError << ", normal error " << worstNormalError << "\n";
+
+	ClearTransforms();
+}
+
+void RunBenchmarks()
+{
+	//Matrix reads per draw should cost a copy, not a rebuild
+	BenchmarkCamera(1000, 200);
+
+	//Local matrices for a whole scene's worth of moving instances
+	BenchmarkTransformBuilder(100000, 10);
+	BenchmarkAffine(100000, 10);
+
+	//Levels past the parallel threshold are split across threads
+	BenchmarkTransforms(1000, 100);
+	BenchmarkTransforms(20000, 20);
+
+	//Binning cost should grow with the light count, not the cluster count
+	BenchmarkLightClusters(256, 20);
+	BenchmarkLightClusters(1024, 20);
+	BenchmarkLightClusters(4096, 10);
+
+	ClearLights();
+}
\ No newline at end of file
@@ -0,0 +1,4 @@
+#pragma once
+
+//Runs the CPU side benchmarks and prints the results, doesn't need a window or GL context
+void RunBenchmarks();
\ No newline at end of file
@@ -1,114 +1,270 @@
 #include "Camera.h"
 #include "glm/glm.hpp"
-#include "glm/gtc/quaternion.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
 
 using glm::vec3;
-using glm::quat;
+using glm::vec4;
+using glm::mat4;
 
-static vec3 position;
-//static quat rotation;
-static vec3 forward;
-static vec3 up;
-static vec3 euler;
-static float fov;
-static float near;
-static float far;
+static Camera* activeCamera = nullptr;
 
-void InitializeCamera()
+Camera::Camera()
 {
 	position = vec3(0.f, 0.f, 0.f);
 	forward = vec3(0.f, 0.f, -1.f);
 	up = vec3(0.f, 1.f, 0.f);
 	euler = vec3(0.f, -90.f, 0.f);
 	fov = 45.f;
-	near = 0.1f;
-	far = 100.f;
+	nearPlane = 0.1f;
+	farPlane = 100.f;
+	viewportWidth = 800;
+	viewportHeight = 600;
+	reverseZ = false;
+	viewDirty = true;
+	projectionDirty = true;
 }
 
-glm::vec3 GetCameraPosition()
+void Camera::UpdateMatrices()
+{
+	if (!viewDirty && !projectionDirty)
+	{
+		return;
+	}
+
+	if (viewDirty)
+	{
+		view = glm::lookAt(position, position + forward, up);
+		inverseView = glm::affineInverse(view);
+	}
+
+	if (projectionDirty)
+	{
+		if (reverseZ)
+		{
+			//Clip depth is the near plane and w the view depth, so depth is near / view depth
+			float scale = 1.f / tan(glm::radians(fov) / 2.f);
+			projection = mat4(0.f);
+			projection[0][0] = scale / GetAspect();
+			projection[1][1] = scale;
+			projection[2][3] = -1.f;
+			projection[3][2] = nearPlane;
+		}
+		else
+		{
+			projection = glm::perspective(glm::radians(fov), GetAspect(), nearPlane, farPlane);
+		}
+
+		inverseProjection = glm::inverse(projection);
+	}
+
+	viewProjection = projection * view;
+	inverseViewProjection = inverseView * inverseProjection;
+
+	//Planes are sums and differences of the clip matrix rows
+	for (int i = 0; i < 3; i++)
+	{
+		vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+		frustumPlanes[i * 2] = w + row;
+		frustumPlanes[i * 2 + 1] = w - row;
+	}
+
+	//Reversed the near plane is depth below w and the far plane has no normal
+	if (reverseZ)
+	{
+		frustumPlanes[4] = frustumPlanes[5];
+	}
+
+	for (vec4& plane : frustumPlanes)
+	{
+		plane /= glm::length(vec3(plane));
+	}
+
+	if (reverseZ)
+	{
+		frustumPlanes[5] = vec4(0.f, 0.f, 0.f, 1.f);
+	}
+
+	viewDirty = false;
+	projectionDirty = false;
+}
+
+glm::vec3 Camera::GetPosition()
 {
 	return position;
 }
 
-glm::vec3 GetCameraForward()
+glm::vec3 Camera::GetForward()
 {
 	return forward;
 }
 
-glm::vec3 GetCameraUp()
+glm::vec3 Camera::GetUp()
 {
 	return up;
 }
 
-void SetCameraPosition(vec3 _position)
+void Camera::SetPosition(vec3 position)
 {
-	position = _position;
+	this->position = position;
+	viewDirty = true;
 }
 
-void TranslateCamera(vec3 translation)
+void Camera::Translate(vec3 translation)
 {
 	position += translation;
+	viewDirty = true;
 }
 
-void SetCameraRotation(glm::vec3 _euler)
+void Camera::SetRotation(glm::vec3 euler)
 {
-	euler = _euler;
+	this->euler = euler;
 
 	//Update forward vector as rotation has changed
 	forward.x = cos(glm::radians(euler.y)) * cos(glm::radians(euler.x));
 	forward.y = sin(glm::radians(euler.x));
 	forward.z = sin(glm::radians(euler.y)) * cos(glm::radians(euler.x));
+	viewDirty = true;
 }
 
-void RotateCamera(glm::vec3 _euler)
+void Camera::Rotate(glm::vec3 euler)
 {
-	SetCameraRotation(euler += _euler);
+	SetRotation(this->euler + euler);
 }
 
-void ClampCameraPitch(float min, float max)
+void Camera::ClampPitch(float min, float max)
 {
 	if (euler.x > max)
 	{
-		SetCameraRotation(vec3(max, euler.y, euler.z));
+		SetRotation(vec3(max, euler.y, euler.z));
 	}
 	else if (euler.x < min)
 	{
-		SetCameraRotation(vec3(min, euler.y, euler.z));
+		SetRotation(vec3(min, euler.y, euler.z));
 	}
 }
 
-void SetCameraFOV(float _fov)
+void Camera::SetFOV(float fov)
 {
-	fov = _fov;
+	this->fov = fov;
+	projectionDirty = true;
 }
 
-float GetCameraFOV()
+float Camera::GetFOV()
 {
 	return fov;
 }
 
-void SetCameraNearFar(float _near, float _far)
+void Camera::SetNearFar(float near, float far)
 {
-	near = _near;
-	far = _far;
+	nearPlane = near;
+	farPlane = far;
+	projectionDirty = true;
 }
 
-float GetCameraNear()
+float Camera::GetNear()
 {
-	return near;
+	return nearPlane;
+}
+
+float Camera::GetFar()
+{
+	return farPlane;
+}
+
+void Camera::SetViewport(unsigned int width, unsigned int height)
+{
+	//Minimized windows report a zero sized framebuffer, keep the last aspect
+	if (width == 0 || height == 0 || (width == viewportWidth && height == viewportHeight))
+	{
+		return;
+	}
+
+	viewportWidth = width;
+	viewportHeight = height;
+	projectionDirty = true;
 }
 
-float GetCameraFar()
+float Camera::GetAspect()
 {
-	return far;
+	return (float)viewportWidth / viewportHeight;
+}
+
+void Camera::SetReverseZ(bool reverseZ)
+{
+	this->reverseZ = reverseZ;
+	projectionDirty = true;
+}
+
+bool Camera::GetReverseZ()
+{
+	return reverseZ;
+}
+
+const glm::mat4& Camera::GetView()
+{
+	UpdateMatrices();
+	return view;
+}
+
+const glm::mat4& Camera::GetProjection()
+{
+	UpdateMatrices();
+	return projection;
+}
+
+const glm::mat4& Camera::GetViewProjection()
+{
+	UpdateMatrices();
+	return viewProjection;
+}
+
+const glm::mat4& Camera::GetInverseView()
+{
+	UpdateMatrices();
+	return inverseView;
+}
+
+const glm::mat4& Camera::GetInverseProjection()
+{
+	UpdateMatrices();
+	return inverseProjection;
+}
+
+const glm::mat4& Camera::GetInverseViewProjection()
+{
+	UpdateMatrices();
+	return inverseViewProjection;
+}
+
+const glm::vec4* Camera::GetFrustumPlanes()
+{
+	UpdateMatrices();
+	return frustumPlanes;
+}
+
+bool Camera::IsSphereVisible(glm::vec3 center, float radius)
+{
+	UpdateMatrices();
+
+	for (const vec4& plane : frustumPlanes)
+	{
+		if (glm::dot(vec3(plane), center) + plane.w < -radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
-glm::mat4 GetCameraView()
+void SetActiveCamera(Camera* camera)
 {
-	return glm::lookAt(position, position + forward, up);
+	activeCamera = camera;
 }
 
-glm::mat4 GetCameraProjection()
+Camera* GetActiveCamera()
 {
-	return glm::perspective(glm::radians(fov), 800.f / 600.f, near, far);
+	return activeCamera;
 }
\ No newline at end of file
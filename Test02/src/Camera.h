@@ -2,22 +2,72 @@
 
 #include "glm/glm.hpp"
 
-void InitializeCamera();
-
-glm::vec3 GetCameraPosition();
-glm::vec3 GetCameraForward();
-glm::vec3 GetCameraUp();
-void SetCameraPosition(glm::vec3 position);
-void TranslateCamera(glm::vec3 translation);
-void SetCameraRotation(glm::vec3 euler);
-void RotateCamera(glm::vec3 euler);
-void ClampCameraPitch(float min, float max);
-
-void SetCameraFOV(float fov);
-float GetCameraFOV();
-void SetCameraNearFar(float near, float far);
-float GetCameraNear();
-float GetCameraFar();
-
-glm::mat4 GetCameraView();
-glm::mat4 GetCameraProjection();
\ No newline at end of file
+//A view into the scene. View, projection, their product, inverses and frustum planes are cached,
+//and only rebuilt on the next read after the position, rotation, FOV, near/far or viewport change.
+class Camera
+{
+private:
+	glm::vec3 position;
+	glm::vec3 forward;
+	glm::vec3 up;
+	glm::vec3 euler;
+	float fov;
+	float nearPlane;
+	float farPlane;
+	unsigned int viewportWidth;
+	unsigned int viewportHeight;
+	bool reverseZ;
+
+	//Cached matrices
+	bool viewDirty;
+	bool projectionDirty;
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseView;
+	glm::mat4 inverseProjection;
+	glm::mat4 inverseViewProjection;
+
+	//Left, right, bottom, top, near, far, normals point inwards
+	glm::vec4 frustumPlanes[6];
+
+	void UpdateMatrices();
+
+public:
+	Camera();
+
+	glm::vec3 GetPosition();
+	glm::vec3 GetForward();
+	glm::vec3 GetUp();
+	void SetPosition(glm::vec3 position);
+	void Translate(glm::vec3 translation);
+	void SetRotation(glm::vec3 euler);
+	void Rotate(glm::vec3 euler);
+	void ClampPitch(float min, float max);
+
+	void SetFOV(float fov);
+	float GetFOV();
+	void SetNearFar(float near, float far);
+	float GetNear();
+	float GetFar();
+	void SetViewport(unsigned int width, unsigned int height);
+	float GetAspect();
+
+	//Infinite far plane with depth running from 1 at the near plane to 0 at infinity, for a ReverseDepth scene buffer.
+	//Far then only limits how far out lights are clustered.
+	void SetReverseZ(bool reverseZ);
+	bool GetReverseZ();
+
+	const glm::mat4& GetView();
+	const glm::mat4& GetProjection();
+	const glm::mat4& GetViewProjection();
+	const glm::mat4& GetInverseView();
+	const glm::mat4& GetInverseProjection();
+	const glm::mat4& GetInverseViewProjection();
+	const glm::vec4* GetFrustumPlanes();
+	bool IsSphereVisible(glm::vec3 center, float radius);
+};
+
+//The camera draws and light binning read from, several cameras can exist but one is active at a time
+void SetActiveCamera(Camera* camera);
+Camera* GetActiveCamera();
\ No newline at end of file
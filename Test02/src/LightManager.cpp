@@ -0,0 +1,449 @@
+#include <glad.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "glm/gtc/type_ptr.hpp"
+#include "LightManager.h"
+#include "JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LIGHTS_USE_SSE
+#endif
+
+using glm::vec3;
+using glm::vec4;
+using glm::mat4;
+
+//Builds with at least this many lights are binned on multiple threads
+#define PARALLEL_BIN_LIGHTS 64
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z)
+//Texels of light data per light, see UploadLightClusters
+#define LIGHT_DATA_TEXELS 4
+
+//Lights, kept as separate arrays so binning can load four positions at a time
+static std::vector<float> lightX, lightY, lightZ, lightRadius;
+static std::vector<vec3> lightColor, lightDirection;
+static std::vector<float> lightIntensity, lightCosInner, lightCosOuter;
+static std::vector<unsigned char> lightType;
+
+static vec3 dirLightDirection(0.f, -1.f, 0.f);
+static vec3 dirLightAmbient(0.f);
+static vec3 dirLightDiffuse(0.f);
+static vec3 dirLightSpecular(0.f);
+
+//Light centers in view space from the last build
+static std::vector<float> viewX, viewY, viewDepth;
+
+//Offset and count into clusterLightIndices for every cluster, z slices outermost
+static std::vector<unsigned int> clusterRanges;
+static std::vector<unsigned int> clusterLightIndices;
+
+static float clusterNear, clusterFar;
+static float clusterDepthScale, clusterDepthBias;
+static float tileWidth, tileHeight;
+
+static unsigned int lightDataBuffer, clusterBuffer, lightIndexBuffer;
+static unsigned int lightDataTexture, clusterTexture, lightIndexTexture;
+
+void InitializeLights()
+{
+	unsigned int* buffers[3] = { &lightDataBuffer, &clusterBuffer, &lightIndexBuffer };
+	unsigned int* textures[3] = { &lightDataTexture, &clusterTexture, &lightIndexTexture };
+	unsigned int formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+
+	for (int i = 0; i < 3; i++)
+	{
+		glGenBuffers(1, buffers[i]);
+		glBindBuffer(GL_TEXTURE_BUFFER, *buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+
+		glGenTextures(1, textures[i]);
+		glBindTexture(GL_TEXTURE_BUFFER, *textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], *buffers[i]);
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void CleanupLights()
+{
+	unsigned int buffers[3] = { lightDataBuffer, clusterBuffer, lightIndexBuffer };
+	unsigned int textures[3] = { lightDataTexture, clusterTexture, lightIndexTexture };
+
+	glDeleteTextures(3, textures);
+	glDeleteBuffers(3, buffers);
+	ClearLights();
+}
+
+static unsigned int AddLight(LightType type, vec3 position, float radius, vec3 direction, float cosInner, float cosOuter, vec3 color, float intensity)
+{
+	lightX.push_back(position.x);
+	lightY.push_back(position.y);
+	lightZ.push_back(position.z);
+	lightRadius.push_back(radius);
+	lightColor.push_back(color);
+	lightDirection.push_back(glm::normalize(direction));
+	lightIntensity.push_back(intensity);
+	lightCosInner.push_back(cosInner);
+	lightCosOuter.push_back(cosOuter);
+	lightType.push_back((unsigned char)type);
+
+	return (unsigned int)lightX.size() - 1;
+}
+
+unsigned int AddPointLight(vec3 position, float radius, vec3 color, float intensity)
+{
+	return AddLight(PointLight, position, radius, vec3(0.f, -1.f, 0.f), -1.f, -1.f, color, intensity);
+}
+
+unsigned int AddSpotLight(vec3 position, float radius, vec3 direction, float innerAngle, float outerAngle, vec3 color, float intensity)
+{
+	return AddLight(SpotLight, position, radius, direction, cos(glm::radians(innerAngle)), cos(glm::radians(outerAngle)), color, intensity);
+}
+
+void SetLightPosition(unsigned int light, vec3 position)
+{
+	lightX[light] = position.x;
+	lightY[light] = position.y;
+	lightZ[light] = position.z;
+}
+
+void SetLightDirection(unsigned int light, vec3 direction)
+{
+	lightDirection[light] = glm::normalize(direction);
+}
+
+void ClearLights()
+{
+	lightX.clear();
+	lightY.clear();
+	lightZ.clear();
+	lightRadius.clear();
+	lightColor.clear();
+	lightDirection.clear();
+	lightIntensity.clear();
+	lightCosInner.clear();
+	lightCosOuter.clear();
+	lightType.clear();
+}
+
+unsigned int GetLightCount()
+{
+	return (unsigned int)lightX.size();
+}
+
+void SetDirectionalLight(vec3 direction, vec3 ambient, vec3 diffuse, vec3 specular)
+{
+	dirLightDirection = glm::normalize(direction);
+	dirLightAmbient = ambient;
+	dirLightDiffuse = diffuse;
+	dirLightSpecular = specular;
+}
+
+//Moves every light center into view space, depth is positive in front of the camera
+static void TransformLightsToView(const mat4& view)
+{
+	size_t count = lightX.size();
+	viewX.resize(count);
+	viewY.resize(count);
+	viewDepth.resize(count);
+
+	size_t i = 0;
+
+#ifdef LIGHTS_USE_SSE
+	//Four lights per iteration, one matrix column broadcast per input axis
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&lightX[i]);
+		__m128 y = _mm_loadu_ps(&lightY[i]);
+		__m128 z = _mm_loadu_ps(&lightZ[i]);
+
+		__m128 outX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view[0][0])), _mm_mul_ps(y, _mm_set1_ps(view[1][0]))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view[2][0])), _mm_set1_ps(view[3][0])));
+		__m128 outY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view[0][1])), _mm_mul_ps(y, _mm_set1_ps(view[1][1]))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view[2][1])), _mm_set1_ps(view[3][1])));
+		__m128 outZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view[0][2])), _mm_mul_ps(y, _mm_set1_ps(view[1][2]))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view[2][2])), _mm_set1_ps(view[3][2])));
+
+		_mm_storeu_ps(&viewX[i], outX);
+		_mm_storeu_ps(&viewY[i], outY);
+		_mm_storeu_ps(&viewDepth[i], _mm_sub_ps(_mm_setzero_ps(), outZ));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		vec4 position = view * vec4(lightX[i], lightY[i], lightZ[i], 1.f);
+		viewX[i] = position.x;
+		viewY[i] = position.y;
+		viewDepth[i] = -position.z;
+	}
+}
+
+static int DepthToSlice(float depth)
+{
+	int slice = (int)std::floor(std::log(depth) * clusterDepthScale + clusterDepthBias);
+	return std::min(std::max(slice, 0), LIGHT_CLUSTERS_Z - 1);
+}
+
+static float SliceToDepth(int slice)
+{
+	return clusterNear * std::pow(clusterFar / clusterNear, (float)slice / LIGHT_CLUSTERS_Z);
+}
+
+struct ClusterBinner
+{
+	//Projection scale, view space x / depth * scale is the NDC x
+	float scaleX, scaleY;
+	int firstSlice, lastSlice;
+	std::vector<unsigned int> counts;
+	std::vector<unsigned int> indices;
+};
+
+//Tile range covered by a circle in view space spread over a depth range, conservative
+static bool TileRange(const ClusterBinner& binner, float x, float y, float radius, float minDepth, float maxDepth, int range[4])
+{
+	if (minDepth <= clusterNear)
+	{
+		range[0] = 0;
+		range[1] = 0;
+		range[2] = LIGHT_CLUSTERS_X - 1;
+		range[3] = LIGHT_CLUSTERS_Y - 1;
+		return true;
+	}
+
+	//The box edges reach furthest out at whichever end of the depth range is nearer
+	float left = std::min((x - radius) / minDepth, (x - radius) / maxDepth) * binner.scaleX;
+	float right = std::max((x + radius) / minDepth, (x + radius) / maxDepth) * binner.scaleX;
+	float bottom = std::min((y - radius) / minDepth, (y - radius) / maxDepth) * binner.scaleY;
+	float top = std::max((y + radius) / minDepth, (y + radius) / maxDepth) * binner.scaleY;
+
+	if (right < -1.f || left > 1.f || top < -1.f || bottom > 1.f)
+	{
+		return false;
+	}
+
+	range[0] = std::max((int)std::floor((left * 0.5f + 0.5f) * LIGHT_CLUSTERS_X), 0);
+	range[1] = std::max((int)std::floor((bottom * 0.5f + 0.5f) * LIGHT_CLUSTERS_Y), 0);
+	range[2] = std::min((int)std::floor((right * 0.5f + 0.5f) * LIGHT_CLUSTERS_X), LIGHT_CLUSTERS_X - 1);
+	range[3] = std::min((int)std::floor((top * 0.5f + 0.5f) * LIGHT_CLUSTERS_Y), LIGHT_CLUSTERS_Y - 1);
+	return true;
+}
+
+//Visits every cluster of the binner's slices a light touches, narrowing to the sphere's cross section per slice
+template <typename Visit>
+static void VisitLightClusters(const ClusterBinner& binner, unsigned int light, Visit visit)
+{
+	float depth = viewDepth[light];
+	float radius = lightRadius[light];
+
+	if (depth + radius < clusterNear || depth - radius > clusterFar)
+	{
+		return;
+	}
+
+	int firstSlice = std::max(DepthToSlice(std::max(depth - radius, clusterNear)), binner.firstSlice);
+	int lastSlice = std::min(DepthToSlice(std::min(depth + radius, clusterFar)), binner.lastSlice);
+
+	for (int slice = firstSlice; slice <= lastSlice; slice++)
+	{
+		float sliceNear = std::max(SliceToDepth(slice), depth - radius);
+		float sliceFar = std::min(SliceToDepth(slice + 1), depth + radius);
+
+		//Widest cross section of the sphere inside this slice
+		float closest = std::min(std::max(depth, sliceNear), sliceFar);
+		float sliceRadius = std::sqrt(std::max(radius * radius - (depth - closest) * (depth - closest), 0.f));
+		int range[4];
+
+		if (!TileRange(binner, viewX[light], viewY[light], sliceRadius, sliceNear, sliceFar, range))
+		{
+			continue;
+		}
+
+		for (int y = range[1]; y <= range[3]; y++)
+		{
+			unsigned int cluster = (slice * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X;
+
+			for (int x = range[0]; x <= range[2]; x++)
+			{
+				visit(cluster + x);
+			}
+		}
+	}
+}
+
+//Counts then fills the index lists of one band of slices, bands never share clusters
+static void BinLights(ClusterBinner* binner)
+{
+	unsigned int firstCluster = binner->firstSlice * LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+	unsigned int clusterCount = (binner->lastSlice - binner->firstSlice + 1) * LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+	unsigned int lightCount = (unsigned int)viewDepth.size();
+
+	binner->counts.assign(clusterCount, 0);
+
+	for (unsigned int light = 0; light < lightCount; light++)
+	{
+		VisitLightClusters(*binner, light, [&](unsigned int cluster) { binner->counts[cluster - firstCluster]++; });
+	}
+
+	//Turn counts into offsets within this band
+	std::vector<unsigned int> cursor(clusterCount);
+	unsigned int total = 0;
+
+	for (unsigned int i = 0; i < clusterCount; i++)
+	{
+		cursor[i] = total;
+		total += binner->counts[i];
+	}
+
+	binner->indices.resize(total);
+
+	for (unsigned int light = 0; light < lightCount; light++)
+	{
+		VisitLightClusters(*binner, light, [&](unsigned int cluster) { binner->indices[cursor[cluster - firstCluster]++] = light; });
+	}
+}
+
+void BuildLightClusters(const mat4& view, const mat4& projection, float near, float far, unsigned int viewportWidth, unsigned int viewportHeight)
+{
+	clusterNear = near;
+	clusterFar = far;
+	clusterDepthScale = LIGHT_CLUSTERS_Z / std::log(far / near);
+	clusterDepthBias = -LIGHT_CLUSTERS_Z * std::log(near) / std::log(far / near);
+	tileWidth = (float)viewportWidth / LIGHT_CLUSTERS_X;
+	tileHeight = (float)viewportHeight / LIGHT_CLUSTERS_Y;
+
+	TransformLightsToView(view);
+
+	unsigned int threadCount = GetJobThreadCount();
+
+	//Few lights aren't worth handing out as jobs
+	if (lightX.size() < PARALLEL_BIN_LIGHTS || threadCount < 2)
+	{
+		threadCount = 1;
+	}
+
+	threadCount = std::min(threadCount, (unsigned int)LIGHT_CLUSTERS_Z);
+
+	std::vector<ClusterBinner> binners(threadCount);
+	unsigned int slicesPerThread = (LIGHT_CLUSTERS_Z + threadCount - 1) / threadCount;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		binners[i].scaleX = projection[0][0];
+		binners[i].scaleY = projection[1][1];
+		binners[i].firstSlice = std::min(i * slicesPerThread, (unsigned int)LIGHT_CLUSTERS_Z);
+		binners[i].lastSlice = std::min((i + 1) * slicesPerThread, (unsigned int)LIGHT_CLUSTERS_Z) - 1;
+	}
+
+	//One job per band, bands past the last slice are empty
+	ParallelFor(0, threadCount, 1, [&binners](unsigned int first, unsigned int last)
+	{
+		for (unsigned int i = first; i < last; i++)
+		{
+			if (binners[i].firstSlice <= binners[i].lastSlice)
+			{
+				BinLights(&binners[i]);
+			}
+		}
+	});
+
+	//Stitch the bands together, they are already in cluster order
+	clusterRanges.resize(LIGHT_CLUSTER_COUNT * 2);
+	clusterLightIndices.clear();
+	unsigned int cluster = 0;
+
+	for (ClusterBinner& binner : binners)
+	{
+		unsigned int offset = (unsigned int)clusterLightIndices.size();
+
+		for (unsigned int count : binner.counts)
+		{
+			clusterRanges[cluster * 2] = offset;
+			clusterRanges[cluster * 2 + 1] = count;
+			offset += count;
+			cluster++;
+		}
+
+		clusterLightIndices.insert(clusterLightIndices.end(), binner.indices.begin(), binner.indices.end());
+	}
+}
+
+unsigned int GetClusterLightCount(unsigned int x, unsigned int y, unsigned int z)
+{
+	return clusterRanges[((z * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X + x) * 2 + 1];
+}
+
+const unsigned int* GetClusterLights(unsigned int x, unsigned int y, unsigned int z)
+{
+	return clusterLightIndices.data() + clusterRanges[((z * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X + x) * 2];
+}
+
+void UploadLightClusters()
+{
+	//Per light: position and radius, color and intensity, direction and type, spot cone cosines
+	std::vector<vec4> lightData(lightX.size() * LIGHT_DATA_TEXELS);
+
+	for (size_t i = 0; i < lightX.size(); i++)
+	{
+		lightData[i * LIGHT_DATA_TEXELS] = vec4(lightX[i], lightY[i], lightZ[i], lightRadius[i]);
+		lightData[i * LIGHT_DATA_TEXELS + 1] = vec4(lightColor[i], lightIntensity[i]);
+		lightData[i * LIGHT_DATA_TEXELS + 2] = vec4(lightDirection[i], (float)lightType[i]);
+		lightData[i * LIGHT_DATA_TEXELS + 3] = vec4(lightCosInner[i], lightCosOuter[i], 0.f, 0.f);
+	}
+
+	//Empty buffers are not allowed, keep at least one element around
+	lightData.resize(std::max(lightData.size(), (size_t)1));
+
+	glBindBuffer(GL_TEXTURE_BUFFER, lightDataBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, lightData.size() * sizeof(vec4), lightData.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, clusterBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, clusterRanges.size() * sizeof(unsigned int), clusterRanges.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, lightIndexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, std::max(clusterLightIndices.size(), (size_t)1) * sizeof(unsigned int), clusterLightIndices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+LightClusterUniforms GetLightClusterUniforms(unsigned int shader)
+{
+	LightClusterUniforms uniforms;
+	uniforms.lightData = glGetUniformLocation(shader, "lightData");
+	uniforms.clusterGrid = glGetUniformLocation(shader, "clusterGrid");
+	uniforms.lightIndices = glGetUniformLocation(shader, "lightIndices");
+	uniforms.clusterTileSize = glGetUniformLocation(shader, "clusterTileSize");
+	uniforms.clusterDepth = glGetUniformLocation(shader, "clusterDepth");
+	uniforms.dirDirection = glGetUniformLocation(shader, "dirLight.direction");
+	uniforms.dirAmbient = glGetUniformLocation(shader, "dirLight.ambient");
+	uniforms.dirDiffuse = glGetUniformLocation(shader, "dirLight.diffuse");
+	uniforms.dirSpecular = glGetUniformLocation(shader, "dirLight.specular");
+	return uniforms;
+}
+
+void ApplyLightClusters(const LightClusterUniforms& uniforms)
+{
+	if (uniforms.dirDirection != -1) glUniform3fv(uniforms.dirDirection, 1, glm::value_ptr(dirLightDirection));
+	if (uniforms.dirAmbient != -1) glUniform3fv(uniforms.dirAmbient, 1, glm::value_ptr(dirLightAmbient));
+	if (uniforms.dirDiffuse != -1) glUniform3fv(uniforms.dirDiffuse, 1, glm::value_ptr(dirLightDiffuse));
+	if (uniforms.dirSpecular != -1) glUniform3fv(uniforms.dirSpecular, 1, glm::value_ptr(dirLightSpecular));
+
+	if (uniforms.clusterGrid == -1)
+	{
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + LIGHT_DATA_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, lightDataTexture);
+	glActiveTexture(GL_TEXTURE0 + LIGHT_CLUSTER_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, clusterTexture);
+	glActiveTexture(GL_TEXTURE0 + LIGHT_INDEX_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, lightIndexTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	glUniform1i(uniforms.lightData, LIGHT_DATA_TEXTURE_UNIT);
+	glUniform1i(uniforms.clusterGrid, LIGHT_CLUSTER_TEXTURE_UNIT);
+	glUniform1i(uniforms.lightIndices, LIGHT_INDEX_TEXTURE_UNIT);
+	glUniform2f(uniforms.clusterTileSize, tileWidth, tileHeight);
+	glUniform2f(uniforms.clusterDepth, clusterDepthScale, clusterDepthBias);
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+
+//Froxel grid, screen tiles by exponential depth slices between the cluster near and far planes
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
+
+//Texture units the cluster buffers are bound to, above anything a mesh uses
+#define LIGHT_DATA_TEXTURE_UNIT 8
+#define LIGHT_CLUSTER_TEXTURE_UNIT 9
+#define LIGHT_INDEX_TEXTURE_UNIT 10
+
+enum LightType { PointLight, SpotLight };
+
+//Uniform locations a clustered shader uses, -1 where the shader has none
+struct LightClusterUniforms
+{
+	int lightData;
+	int clusterGrid;
+	int lightIndices;
+	int clusterTileSize;
+	int clusterDepth;
+	int dirDirection;
+	int dirAmbient;
+	int dirDiffuse;
+	int dirSpecular;
+};
+
+void InitializeLights();
+void CleanupLights();
+
+unsigned int AddPointLight(glm::vec3 position, float radius, glm::vec3 color, float intensity);
+unsigned int AddSpotLight(glm::vec3 position, float radius, glm::vec3 direction, float innerAngle, float outerAngle, glm::vec3 color, float intensity);
+void SetLightPosition(unsigned int light, glm::vec3 position);
+void SetLightDirection(unsigned int light, glm::vec3 direction);
+void ClearLights();
+unsigned int GetLightCount();
+
+void SetDirectionalLight(glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular);
+
+//Bins every light into the froxels of the given camera, CPU only so it can run without a context
+void BuildLightClusters(const glm::mat4& view, const glm::mat4& projection, float near, float far, unsigned int viewportWidth, unsigned int viewportHeight);
+unsigned int GetClusterLightCount(unsigned int x, unsigned int y, unsigned int z);
+const unsigned int* GetClusterLights(unsigned int x, unsigned int y, unsigned int z);
+
+//Uploads the last build to the texture buffers
+void UploadLightClusters();
+LightClusterUniforms GetLightClusterUniforms(unsigned int shader);
+void ApplyLightClusters(const LightClusterUniforms& uniforms);
\ No newline at end of file
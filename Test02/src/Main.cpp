@@ -1,13 +1,20 @@
 #include <iostream>
+#include <cstring>
 #include <glad.h>
 #include <glfw3.h>
 #include <vector>
 #include "Shader.h"
 #include "Camera.h"
+#include "SceneBuffer.h"
 #include "Model.h"
 #include "ModelInstance.h"
 #include "Meshes.h"
 #include "Texture.h"
+#include "LightManager.h"
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Headless.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -24,6 +31,15 @@ using glm::mat4;
 #define WINDOW_WIDTH 1440
 #define WINDOW_HEIGHT 1080
 
+//Point lights scattered around the sponza atrium
+#define SCENE_LIGHT_COUNT 256
+
+//Written in the working directory when the trace key is pressed
+#define PROFILER_TRACE_PATH "profile.json"
+
+//Scene camera, steered by the input callbacks
+static Camera camera;
+
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
@@ -37,6 +53,17 @@ void ProcessInput(GLFWwindow* window, float dt)
 		glfwSetWindowShouldClose(window, true);
 	}
 
+	//Dump the profiler's last few seconds once per press
+	static bool tracePressed = false;
+	bool traceKey = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+
+	if (traceKey && !tracePressed)
+	{
+		WriteProfilerTrace(PROFILER_TRACE_PATH);
+	}
+
+	tracePressed = traceKey;
+
 	//Camera controls
 	float cameraMoveSpeed = 1.f * dt;
 
@@ -48,31 +75,31 @@ void ProcessInput(GLFWwindow* window, float dt)
 	//Forward/Back
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 	{
-		TranslateCamera(GetCameraForward() * cameraMoveSpeed);
+		camera.Translate(camera.GetForward() * cameraMoveSpeed);
 	}
 	else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
 	{
-		TranslateCamera(-GetCameraForward() * cameraMoveSpeed);
+		camera.Translate(-camera.GetForward() * cameraMoveSpeed);
 	}
 	
 	//Left/Right
 	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
 	{
-		TranslateCamera(-glm::normalize(glm::cross(GetCameraForward(), GetCameraUp())) * cameraMoveSpeed);
+		camera.Translate(-glm::normalize(glm::cross(camera.GetForward(), camera.GetUp())) * cameraMoveSpeed);
 	}
 	else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
 	{
-		TranslateCamera(glm::normalize(glm::cross(GetCameraForward(), GetCameraUp())) * cameraMoveSpeed);
+		camera.Translate(glm::normalize(glm::cross(camera.GetForward(), camera.GetUp())) * cameraMoveSpeed);
 	}
 
 	//Up/Down
 	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
 	{
-		TranslateCamera(GetCameraUp() * cameraMoveSpeed);
+		camera.Translate(camera.GetUp() * cameraMoveSpeed);
 	}
 	else if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
 	{
-		TranslateCamera(-GetCameraUp() * cameraMoveSpeed);
+		camera.Translate(-camera.GetUp() * cameraMoveSpeed);
 	}
 }
 
@@ -97,143 +124,276 @@ void MousePositionCallback(GLFWwindow* window, double mouseX, double mouseY)
 	const float sensitivity = 0.1f;
 
 	//Affect camera
-	RotateCamera(vec3(-mouseDeltaY, mouseDeltaX, 0.f) * sensitivity);
-	ClampCameraPitch(-89.f, 89.f);
+	camera.Rotate(vec3(-mouseDeltaY, mouseDeltaX, 0.f) * sensitivity);
+	camera.ClampPitch(-89.f, 89.f);
 }
 
 void MouseScrollCallback(GLFWwindow* window, double scrollX, double scrollY)
 {
-	SetCameraFOV(GetCameraFOV() - (float)scrollY);
+	camera.SetFOV(camera.GetFOV() - (float)scrollY);
 }
 
-int main()
+//Loads a model under a profiler scope of its own, the model outlives the scope
+Model LoadSceneModel(const char* scopeName, const char* path)
 {
-	//aiScene scene;
+	PROFILE_SCOPE(scopeName);
+	return Model(path);
+}
 
-	//Initialize GLFW and create window
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+int main(int argc, char** argv)
+{
+	//aiScene scene;
 
-	GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Test01 - Lighting", nullptr, nullptr);
+	//Worker threads for everything that fans out, this thread stays the GL thread
+	JobSystemScope jobs(0);
 
-	if (window == nullptr)
+	//Benchmarks only need the CPU side, skip the window entirely
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
 	{
-		std::cout << "Failed to create GLFW window\n";
-		glfwTerminate();
-		return -1;
+		RunBenchmarks();
+		return 0;
 	}
 
-	glfwMakeContextCurrent(window);
+	//Fixed runs without a display for the performance suite
+	HeadlessOptions headless = ParseHeadlessOptions(argc, argv);
 
-	//Initialize GLAD
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	//Headless runs make their own context and load GL with it, GLFW is never initialized for them
+	GLFWwindow* window = nullptr;
+
+	if (headless.enabled)
 	{
-		std::cout << "Failed to initialize GLAD\n";
-		return -1;
+		if (!CreateHeadlessContext(WINDOW_WIDTH, WINDOW_HEIGHT))
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		//Initialize GLFW and create window
+		if (!glfwInit())
+		{
+			std::cout << "Failed to initialize GLFW\n";
+			return -1;
+		}
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Test01 - Lighting", nullptr, nullptr);
+
+		if (window == nullptr)
+		{
+			std::cout << "Failed to create GLFW window\n";
+			glfwTerminate();
+			return -1;
+		}
+
+		glfwMakeContextCurrent(window);
+
+		//Initialize GLAD
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD\n";
+			glfwTerminate();
+			return -1;
+		}
 	}
 
 	//Set up viewport
 	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
 
-	//Hook up window size change callback
-	glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
-
-	//Setup mouse input
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetCursorPosCallback(window, MousePositionCallback);
-	glfwSetScrollCallback(window, MouseScrollCallback);
+	//Hook up window size change callback and mouse input, headless runs keep the viewport on their fixed target
+	if (!headless.enabled)
+	{
+		glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetCursorPosCallback(window, MousePositionCallback);
+		glfwSetScrollCallback(window, MouseScrollCallback);
+	}
 
 	//Initialize game systems
-	InitializeCamera();
+	SetActiveCamera(&camera);
+	InitializeLights();
+	InitializeShaders();
+	InitializeGpuProfiler();
 
 	//Time keeping
 	float deltaTime = 0.f;
 	float previousTime = 0.f;
 
 	//Set up camera
-	SetCameraPosition(vec3(2.f, 1.f, 2.f));
-	SetCameraRotation(vec3(-20.f, 230.f, 0.f));
-	SetCameraFOV(75.f);
-	SetCameraNearFar(0.1f, 50.f);
-
-	//Load shaders
-	unsigned int testShader = CreateShaderProgram("shaders/test.vert", "shaders/test.frag");
-	unsigned int colorShader = CreateShaderProgram("shaders/color.vert", "shaders/color.frag");
-	unsigned int phongShader = CreateShaderProgram("shaders/tex_phong.vert", "shaders/tex_phong.frag");
-	unsigned int gouraudShader = CreateShaderProgram("shaders/tex_gouraud.vert", "shaders/tex_gouraud.frag");
-	unsigned int materialShader = CreateShaderProgram("shaders/tex_material.vert", "shaders/tex_material.frag");
-	unsigned int materialMapShader = CreateShaderProgram("shaders/tex_material_map.vert", "shaders/tex_material_map.frag");
-	unsigned int materialMapDirectionalShader = CreateShaderProgram("shaders/tex_material_map_directional.vert", "shaders/tex_material_map_directional.frag");
-	unsigned int materialMapPointShader = CreateShaderProgram("shaders/tex_material_map_point.vert", "shaders/tex_material_map_point.frag");
-	unsigned int materialMapSpotShader = CreateShaderProgram("shaders/tex_material_map_spot.vert", "shaders/tex_material_map_spot.frag");
-	unsigned int materialMapMultiLightShader = CreateShaderProgram("shaders/tex_material_map_multi_light.vert", "shaders/tex_material_map_multi_light.frag");
-	unsigned int foliageShader = CreateShaderProgram("shaders/foliage.vert", "shaders/foliage.frag");
+	camera.SetPosition(vec3(2.f, 1.f, 2.f));
+	camera.SetRotation(vec3(-20.f, 230.f, 0.f));
+	camera.SetFOV(75.f);
+	//With reversed depth nothing is clipped past far, it only bounds the light clusters
+	camera.SetNearFar(0.1f, 50.f);
+
+	//Shader variants, each is only compiled the first time something draws with it
+	ShaderVariant testShader = GetShaderVariant("shaders/test.vert", "shaders/test.frag", "");
+	ShaderVariant colorShader = GetShaderVariant("shaders/color.vert", "shaders/color.frag", "");
+	ShaderVariant phongShader = GetShaderVariant("shaders/tex_phong.vert", "shaders/tex_phong.frag", "");
+	ShaderVariant gouraudShader = GetShaderVariant("shaders/tex_gouraud.vert", "shaders/tex_gouraud.frag", "");
+	ShaderVariant materialShader = GetShaderVariant("shaders/tex_material.vert", "shaders/tex_material.frag", "");
+	ShaderVariant materialMapShader = GetShaderVariant("shaders/tex_material_map_lit.vert", "shaders/tex_material_map_lit.frag", "POINT_LIGHT");
+	ShaderVariant materialMapDirectionalShader = GetShaderVariant("shaders/tex_material_map_lit.vert", "shaders/tex_material_map_lit.frag", "DIRECTIONAL_LIGHT");
+	ShaderVariant materialMapPointShader = GetShaderVariant("shaders/tex_material_map_lit.vert", "shaders/tex_material_map_lit.frag", "POINT_LIGHT FOG");
+	ShaderVariant materialMapSpotShader = GetShaderVariant("shaders/tex_material_map_lit.vert", "shaders/tex_material_map_lit.frag", "SPOT_LIGHT");
+	ShaderVariant materialMapMultiLightShader = GetShaderVariant("shaders/tex_material_map_lit.vert", "shaders/tex_material_map_lit.frag", "DIRECTIONAL_LIGHT CLUSTERED_LIGHTS");
+	ShaderVariant foliageShader = GetShaderVariant("shaders/foliage.vert", "shaders/foliage.frag", "");
+
+	//Start the ones the scene draws right away so they build together, the rest wait for first use
+	PrepareShaderVariant(materialMapMultiLightShader);
+	PrepareShaderVariant(foliageShader);
+	PrepareShaderVariant(colorShader);
 	
 	//Default draw settings
 	glEnable(GL_DEPTH_TEST);
 	glDepthMask(GL_TRUE);
-	glDepthFunc(GL_LESS);
 	glEnable(GL_STENCIL_TEST);
 	glStencilMask(0x00);
 	glStencilOp(GL_KEEP, GL_REPLACE, GL_REPLACE);
 	glEnable(GL_BLEND);
 
+	//Reversed depth keeps its precision out to an infinite far plane, headless runs stay at the window size
+	int framebufferWidth = WINDOW_WIDTH, framebufferHeight = WINDOW_HEIGHT;
+
+	if (!headless.enabled)
+	{
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	}
+
+	InitializeSceneBuffer(ReverseDepth, framebufferWidth, framebufferHeight);
+
+	if (headless.enabled)
+	{
+		if (!InitializeHeadlessTarget(framebufferWidth, framebufferHeight))
+		{
+			DestroyHeadlessContext();
+			return -1;
+		}
+
+		SetSceneOutput(GetHeadlessFramebuffer());
+	}
+
+	camera.SetReverseZ(GetSceneDepthMode() == ReverseDepth);
+
 	//Load models
-	Model sponzaModel("Models/sponza/sponza.obj");
-	ModelInstance sponza(&sponzaModel, materialMapPointShader);
+	Model sponzaModel = LoadSceneModel("Load sponza", "Models/sponza/sponza.obj");
+	ModelInstance sponza(&sponzaModel, materialMapMultiLightShader);
 	sponza.SetScale(vec3(0.01f, 0.01f, 0.01f));
 
-	Model backpackModel("Models/backpack/backpack.obj");
-	ModelInstance backpack(&backpackModel, materialMapPointShader);
+	Model backpackModel = LoadSceneModel("Load backpack", "Models/backpack/backpack.obj");
+	ModelInstance backpack(&backpackModel, materialMapMultiLightShader);
 
 	//Set up grass
 	Model grassModel(quadVerts, sizeof(quadVerts) / 8 / 4, quadIndices, sizeof(quadIndices) / 4);
-	Texture grassTexture(Texture::Diffuse, LoadTexture("textures/grass.png", GL_CLAMP_TO_EDGE));
-	grassModel.meshes[0].textures.push_back(grassTexture);
-
 	std::vector<ModelInstance> foliage;
-	
-	for (int i = 0; i < 1000; i++)
+
 	{
-		ModelInstance grass(&grassModel, foliageShader);
-		grass.SetPosition(vec3(glm::linearRand(-14.f, 14.f), 0.f, glm::linearRand(-7.f, 7.f)));
-		grass.SetRotation(vec3(0.f, glm::linearRand(0.f, 360.f), 0.f));
-		grass.SetScale(vec3(0.5f));
-		foliage.push_back(grass);
+		PROFILE_SCOPE("Set up grass");
+		Texture grassTexture(Texture::Diffuse, LoadTexture("textures/grass.png", GL_CLAMP_TO_EDGE));
+		grassModel.meshes[0].textures.push_back(grassTexture);
+
+		for (int i = 0; i < 1000; i++)
+		{
+			ModelInstance grass(&grassModel, foliageShader);
+			grass.SetPosition(vec3(glm::linearRand(-14.f, 14.f), 0.f, glm::linearRand(-7.f, 7.f)));
+			grass.SetRotation(vec3(0.f, glm::linearRand(0.f, 360.f), 0.f));
+			grass.SetScale(vec3(0.5f));
+			foliage.push_back(grass);
+		}
 	}
 
-	Model monkeyModel("Models/smooth_monke.obj");
+	Model monkeyModel = LoadSceneModel("Load monkey", "Models/smooth_monke.obj");
 	//Model monkeyModel(cubeVerts, sizeof(cubeVerts) / 8 / 4, cubeIndices, sizeof(cubeIndices) / 4);
-	ModelInstance monkey(&monkeyModel, materialMapPointShader);
+	ModelInstance monkey(&monkeyModel, materialMapMultiLightShader);
 	monkey.SetPosition(vec3(-3.f, 1.f, 0.f));
 	monkey.SetScale(vec3(0.35f));
 
 	//Add texture manually
-	Texture monkeyTexture(Texture::Diffuse, LoadTexture("textures/test.png"));
-	monkeyModel.meshes[0].textures.push_back(monkeyTexture);
+	{
+		PROFILE_SCOPE("Load monkey texture");
+		Texture monkeyTexture(Texture::Diffuse, LoadTexture("textures/test.png"));
+		monkeyModel.meshes[0].textures.push_back(monkeyTexture);
+	}
+
+	//Set up lights
+	SetDirectionalLight(vec3(-0.2f, -1.f, -0.3f), vec3(0.15f), vec3(0.3f), vec3(0.2f));
+
+	for (int i = 0; i < SCENE_LIGHT_COUNT; i++)
+	{
+		vec3 position(glm::linearRand(-14.f, 14.f), glm::linearRand(0.2f, 4.f), glm::linearRand(-7.f, 7.f));
+		vec3 color = glm::rgbColor(vec3(glm::linearRand(0.f, 360.f), 0.8f, 1.f));
+		AddPointLight(position, glm::linearRand(1.5f, 3.f), color, 2.f);
+	}
+
+	AddSpotLight(vec3(-10.f, 5.f, 0.f), 12.f, vec3(0.3f, -1.f, 0.f), 20.f, 30.f, vec3(1.f, 0.9f, 0.7f), 20.f);
+	AddSpotLight(vec3(10.f, 5.f, 0.f), 12.f, vec3(-0.3f, -1.f, 0.f), 20.f, 30.f, vec3(0.7f, 0.9f, 1.f), 20.f);
+	unsigned int monkeyLight = AddPointLight(vec3(0.f), 4.f, vec3(1.f, 0.3f, 0.2f), 4.f);
 
-	//Set up light
-	SetLightPosition(vec3(2.f, 2.f, 2.f));
-	SetLightColor(vec3(1.f, 0.3f, 0.2f), vec3(0.5f, 0.7f, 0.3f), vec3(0.3f));
-	SetLightAttenuation(1.f, 0.09f, 0.032f);
+	//Attached to the monkey so it circles it as the monkey spins, offset in the monkey's scaled space
+	Transform monkeyLightTransform = CreateTransform(monkey.GetTransform());
+	SetTransformPosition(monkeyLightTransform, vec3(0.f, 1.f, 3.f));
 
 	//Update loop
-	while (!glfwWindowShouldClose(window))
+	unsigned int frame = 0;
+
+	if (headless.enabled)
+	{
+		BeginHeadlessRun();
+	}
+
+	while (headless.enabled ? frame < headless.frameCount : !glfwWindowShouldClose(window))
 	{
+		PROFILE_SCOPE("Frame");
+
 		//Track time
-		float time = glfwGetTime();
+		float time = headless.enabled ? (float)(frame * HEADLESS_FRAME_TIME) : (float)glfwGetTime();
 		deltaTime = time - previousTime;
 		previousTime = time;
 
-		//Update
-		ProcessInput(window, deltaTime);
+		//Update, headless runs have no input to read
+		if (!headless.enabled)
+		{
+			ProcessInput(window, deltaTime);
+		}
+
 		monkey.SetPosition(vec3(sin(time / 2.5f) * 8.f, 1.2f, 0.f));
 		monkey.SetRotation(vec3(0.f, time * 90.f, 0.f));
-		SetLightPosition(monkey.GetPosition());
+
+		//World matrices of everything moved this frame and whatever is attached to it
+		{
+			PROFILE_SCOPE("Update transforms");
+			UpdateTransforms();
+		}
+
+		SetLightPosition(monkeyLight, GetWorldPosition(monkeyLightTransform));
+
+		//Match the camera and scene buffer to the window and bin lights for this frame's view
+		if (!headless.enabled)
+		{
+			glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		}
+
+		camera.SetViewport(framebufferWidth, framebufferHeight);
+		ResizeSceneBuffer(framebufferWidth, framebufferHeight);
+
+		{
+			PROFILE_SCOPE("Build light clusters");
+			BuildLightClusters(camera.GetView(), camera.GetProjection(), camera.GetNear(), camera.GetFar(), framebufferWidth, framebufferHeight);
+			UploadLightClusters();
+		}
+
+		//Rebuild shaders edited on disk and pick up any variants that finished building
+		ReloadChangedShaders();
+		UpdateShaderVariants();
+
+		//GL work jobs handed back to this thread
+		RunMainThreadJobs();
 
 		//Clear
+		BindSceneBuffer();
 		glClearColor(0.7f, 0.7f, 0.7f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
@@ -241,43 +401,83 @@ int main()
 		glStencilMask(0x00);
 
 		//Draw
-		sponza.Draw();
+		{
+			PROFILE_SCOPE("Sponza");
+			PROFILE_GPU_SCOPE("Sponza");
+			sponza.Draw();
+		}
 
-		for (ModelInstance grass : foliage)
 		{
-			grass.Draw();
+			PROFILE_SCOPE("Foliage");
+			PROFILE_GPU_SCOPE("Foliage");
+
+			for (ModelInstance& grass : foliage)
+			{
+				grass.Draw();
+			}
 		}
-		
 
 		//Draw monkey with stencil outline
-		glStencilFunc(GL_ALWAYS, 1, 0xFF);
-		glStencilMask(0xFF);
-		monkey.Draw();
-
-		glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-		glStencilMask(0x00); // disable writing to the stencil buffer
-		glDisable(GL_DEPTH_TEST);
-		vec3 oldScale = monkey.GetScale();
-		unsigned int oldShader = monkey.GetShader();
-		monkey.SetShader(colorShader);
-		monkey.Draw();
-		monkey.SetShader(oldShader);
-		glStencilMask(0xFF);
-		glStencilFunc(GL_ALWAYS, 1, 0xFF);
-		glEnable(GL_DEPTH_TEST);
+		{
+			PROFILE_SCOPE("Monkey");
+			PROFILE_GPU_SCOPE("Monkey");
+			glStencilFunc(GL_ALWAYS, 1, 0xFF);
+			glStencilMask(0xFF);
+			monkey.Draw();
+
+			glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+			glStencilMask(0x00); // disable writing to the stencil buffer
+			glDisable(GL_DEPTH_TEST);
+			vec3 oldScale = monkey.GetScale();
+			ShaderVariant oldShader = monkey.GetShader();
+			monkey.SetShader(colorShader);
+			monkey.Draw();
+			monkey.SetShader(oldShader);
+			glStencilMask(0xFF);
+			glStencilFunc(GL_ALWAYS, 1, 0xFF);
+			glEnable(GL_DEPTH_TEST);
+		}
 
 
 		//glDepthMask(GL_FALSE);
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		{
+			PROFILE_GPU_SCOPE("Present");
+			PresentSceneBuffer();
+		}
+
+		if (!headless.enabled)
+		{
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+
+		//Collect whatever GPU timings have come back since last frame
+		UpdateGpuProfiler();
+		frame++;
+	}
+
+	if (headless.enabled)
+	{
+		EndHeadlessRun(headless, frame);
 	}
 
 	//Cleanup
+	CleanupGpuProfiler();
+	CleanupSceneBuffer();
+	CleanupHeadlessTarget();
+	CleanupLights();
 	CleanupShaders();
 
-	//Clean up GLFW
-	glfwTerminate();
+	//Clean up the context
+	if (headless.enabled)
+	{
+		DestroyHeadlessContext();
+	}
+	else
+	{
+		glfwTerminate();
+	}
 
 	return 0;
 }
@@ -6,17 +6,28 @@
 #include <assimp/postprocess.h>
 #include <vector>
 #include <string>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
 #include "Texture.h"
 #include "Model.h"
 #include "Camera.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 
 using std::vector;
 using glm::vec3;
 using glm::vec4;
 using glm::mat4;
 
+//What each instance of a mesh reads, the node transform and the normal matrix that goes with it
+struct NodeInstance
+{
+    Affine transform;
+    glm::mat3 normal;
+};
+
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
 {
     this->vertices = vertices;
@@ -50,14 +61,55 @@ void Mesh::SetupMesh()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)offsetof(Vertex, uv)); //uv
     glEnableVertexAttribArray(2);
 
+    //Node transform per instance, a mat3x4 takes one attribute per row of the affine transform
+    glGenBuffers(1, &instanceVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+
+    for (int i = 0; i < 3; i++)
+    {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(NodeInstance), (void*)(i * sizeof(vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
+
+    //Normal matrix per instance, one attribute per column of the mat3
+    for (int i = 0; i < 3; i++)
+    {
+        glVertexAttribPointer(6 + i, 3, GL_FLOAT, GL_FALSE, sizeof(NodeInstance), (void*)(offsetof(NodeInstance, normal) + i * sizeof(vec3)));
+        glEnableVertexAttribArray(6 + i);
+        glVertexAttribDivisor(6 + i, 1);
+    }
+
     //Unbind buffers
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+void Mesh::UploadNodeTransforms()
+{
+    //Node transforms are fixed once loaded, so their normal matrices are worked out here rather than per vertex
+    std::vector<NodeInstance> instances(nodeTransforms.size());
+
+    for (size_t i = 0; i < nodeTransforms.size(); i++)
+    {
+        instances[i].transform = nodeTransforms[i];
+        instances[i].normal = GetNormalMatrix(nodeTransforms[i]);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(NodeInstance), instances.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void Mesh::Draw(unsigned int shader)
 {
+    //Not referenced by any node
+    if (nodeTransforms.empty())
+    {
+        return;
+    }
+
     //Pass textures to shader program
     unsigned int diffuseNr = 1;
     unsigned int specularNr = 1;
@@ -89,7 +141,7 @@ void Mesh::Draw(unsigned int shader)
 
     //Draw mesh
     glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, nodeTransforms.size());
     glBindVertexArray(0);
 }
 
@@ -126,57 +178,34 @@ Model::Model(float* meshVertices, int numVertices, unsigned int* meshIndices, in
     }
 
     meshes.push_back(Mesh(vertices, indices, std::vector<Texture>()));
+    meshes.back().nodeTransforms.push_back(IdentityAffine());
+    meshes.back().UploadNodeTransforms();
 }
 
-void Model::Draw(unsigned int shader)
+void Model::Draw(unsigned int shader, int modelUniform, const Affine& world, int normalUniform, const glm::mat3& normal)
 {
-    for (unsigned int i = 0; i < meshes.size(); i++)
+    //The rows go in as the columns of the shader's mat3x4
+    if (modelUniform != -1)
     {
-        meshes[i].Draw(shader);
+        glUniformMatrix3x4fv(modelUniform, 1, GL_FALSE, &world.rows[0].x);
     }
-}
 
-void Model::LoadModel(std::string path)
-{
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
-
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    if (normalUniform != -1)
     {
-        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-        return;
+        glUniformMatrix3fv(normalUniform, 1, GL_FALSE, glm::value_ptr(normal));
     }
 
-    directory = path.substr(0, path.find_last_of('/'));
-
-    std::filesystem::path p(path);
-
-    LoadNode(scene->mRootNode, scene, p.parent_path().generic_string() + "/");
-}
-
-void Model::LoadNode(aiNode* node, const aiScene* scene, std::string path)
-{
-    // process all the node's meshes (if any)
-    for (unsigned int i = 0; i < node->mNumMeshes; i++)
-    {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(LoadMesh(mesh, scene, path));
-    }
-
-    //std::cout << "child count: " << node->mNumChildren << std::endl;
-
-    // then do the same for each of its children
-    for (unsigned int i = 0; i < node->mNumChildren; i++)
+    for (unsigned int i = 0; i < meshes.size(); i++)
     {
-        LoadNode(node->mChildren[i], scene, path);
+        meshes[i].Draw(shader);
     }
 }
 
-Mesh Model::LoadMesh(aiMesh* mesh, const aiScene* scene, std::string path)
+//Only reads the Assimp mesh, so meshes can be converted side by side
+static void ConvertMeshGeometry(const aiMesh* mesh, vector<Vertex>& vertices, vector<unsigned int>& indices)
 {
-    vector<Vertex> vertices;
-    vector<unsigned int> indices;
-    vector<Texture> textures;
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(mesh->mNumFaces * 3);
 
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
@@ -219,6 +248,89 @@ Mesh Model::LoadMesh(aiMesh* mesh, const aiScene* scene, std::string path)
             indices.push_back(face.mIndices[j]);
         }
     }
+}
+
+void Model::LoadModel(std::string path)
+{
+    PROFILE_SCOPE("Load model");
+    Assimp::Importer importer;
+    const aiScene* scene;
+
+    {
+        PROFILE_SCOPE("Import model");
+        scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+    }
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return;
+    }
+
+    directory = path.substr(0, path.find_last_of('/'));
+
+    std::filesystem::path p(path);
+
+    std::string textureDirectory = p.parent_path().generic_string() + "/";
+    PreloadTextures(scene, textureDirectory);
+
+    //Geometry is converted on the job threads, the GL buffers are made here after
+    vector<vector<Vertex>> meshVertices(scene->mNumMeshes);
+    vector<vector<unsigned int>> meshIndices(scene->mNumMeshes);
+
+    ParallelFor(0, scene->mNumMeshes, 1, [&](unsigned int first, unsigned int last)
+    {
+        PROFILE_SCOPE("Convert meshes");
+
+        for (unsigned int i = first; i < last; i++)
+        {
+            ConvertMeshGeometry(scene->mMeshes[i], meshVertices[i], meshIndices[i]);
+        }
+    });
+
+    //Meshes are converted once in scene order, nodes only add instances of them
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+    {
+        meshes.push_back(LoadMesh(scene->mMeshes[i], scene, textureDirectory, meshVertices[i], meshIndices[i]));
+    }
+
+    LoadNode(scene->mRootNode, scene, IdentityAffine());
+    unsigned int instanceCount = 0;
+
+    for (Mesh& mesh : meshes)
+    {
+        mesh.UploadNodeTransforms();
+        instanceCount += mesh.nodeTransforms.size();
+    }
+
+    std::cout << "Loaded " << path << ": " << meshes.size() << " meshes drawn " << instanceCount << " times\n";
+}
+
+void Model::LoadNode(aiNode* node, const aiScene* scene, const Affine& parentTransform)
+{
+    //Assimp matrices are row major, their top three rows are the affine transform as is
+    Affine local;
+    std::memcpy(&local, &node->mTransformation.a1, sizeof(Affine));
+    Affine transform = ComposeAffine(parentTransform, local);
+
+    // process all the node's meshes (if any)
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+    {
+        meshes[node->mMeshes[i]].nodeTransforms.push_back(transform);
+    }
+
+    //std::cout << "child count: " << node->mNumChildren << std::endl;
+
+    // then do the same for each of its children
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+    {
+        LoadNode(node->mChildren[i], scene, transform);
+    }
+}
+
+Mesh Model::LoadMesh(aiMesh* mesh, const aiScene* scene, std::string path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    vector<Texture> textures;
 
     if (mesh->mMaterialIndex >= 0)
     {
@@ -232,6 +344,63 @@ Mesh Model::LoadMesh(aiMesh* mesh, const aiScene* scene, std::string path)
     return Mesh(vertices, indices, textures);
 }
 
+void Model::PreloadTextures(const aiScene* scene, std::string path)
+{
+    struct PendingTexture
+    {
+        std::string fileName;
+        Texture::TextureType type;
+        TextureImage image;
+    };
+
+    const aiTextureType types[2] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR };
+    const Texture::TextureType myTypes[2] = { Texture::Diffuse, Texture::Specular };
+    vector<PendingTexture> pending;
+
+    //Same walk as LoadMesh, so every file keeps the type it is first used as
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+    {
+        aiMaterial* material = scene->mMaterials[scene->mMeshes[i]->mMaterialIndex];
+
+        for (int type = 0; type < 2; type++)
+        {
+            for (unsigned int j = 0; j < material->GetTextureCount(types[type]); j++)
+            {
+                aiString textureFileName;
+                material->GetTexture(types[type], j, &textureFileName);
+                auto sameFile = [&](const std::string& fileName) { return fileName == textureFileName.C_Str(); };
+
+                if (std::none_of(loadedTextures.begin(), loadedTextures.end(), [&](const Texture& texture) { return sameFile(texture.path); }) &&
+                    std::none_of(pending.begin(), pending.end(), [&](const PendingTexture& texture) { return sameFile(texture.fileName); }))
+                {
+                    pending.push_back({ textureFileName.C_Str(), myTypes[type], TextureImage() });
+                }
+            }
+        }
+    }
+
+    //Each texture is uploaded on this thread as soon as its own decode is done, while the rest keep decoding
+    vector<JobCounter> decoded(pending.size());
+    JobCounter uploaded;
+
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        PendingTexture& texture = pending[i];
+        RunJob([&texture, &path]() { texture.image = DecodeTexture((path + texture.fileName).c_str()); }, &decoded[i]);
+
+        RunOnMainThreadAfter(&decoded[i], [this, &texture]()
+        {
+            Texture loaded;
+            loaded.id = UploadTexture(texture.image, GL_REPEAT);
+            loaded.type = texture.type;
+            loaded.path = texture.fileName;
+            loadedTextures.push_back(loaded);
+        }, &uploaded);
+    }
+
+    WaitForCounter(uploaded);
+}
+
 vector<Texture> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType type, Texture::TextureType myType, std::string path)
 {
     vector<Texture> textures;
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <assimp/scene.h>
+#include "Affine.h"
 
 struct Vertex
 {
@@ -30,11 +31,15 @@ struct Mesh
 	std::vector<Vertex> vertices;
 	std::vector<unsigned int> indices;
 	std::vector<Texture> textures;
+	//Transform of every node that references the mesh relative to the model's root, one instance each
+	std::vector<Affine> nodeTransforms;
 
 	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
+	//Uploads nodeTransforms to the instance buffer, vertex attributes 3 to 5, with their normal matrices in 6 to 8
+	void UploadNodeTransforms();
 	void Draw(unsigned int shader);
 private:
-	unsigned int vao, vbo, ebo;
+	unsigned int vao, vbo, ebo, instanceVbo;
 
 	void SetupMesh();
 };
@@ -44,7 +49,8 @@ class Model
 public:
 	Model(const char* path);
 	Model(float* meshVertices, int numVertices, unsigned int* meshIndices, int numIndices);
-	void Draw(unsigned int shader);
+	//Each mesh is drawn once, instanced over the nodes that reference it
+	void Draw(unsigned int shader, int modelUniform, const Affine& world, int normalUniform, const glm::mat3& normal);
 	// model data
 	std::vector<Mesh> meshes;
 private:
@@ -53,7 +59,9 @@ private:
 	std::vector<Texture> loadedTextures;
 
 	void LoadModel(std::string path);
-	void LoadNode(aiNode* node, const aiScene* scene, std::string path);
-	Mesh LoadMesh(aiMesh* mesh, const aiScene* scene, std::string path);
+	void LoadNode(aiNode* node, const aiScene* scene, const Affine& parentTransform);
+	//Decodes every texture the meshes use on the job threads, then uploads them in the order the meshes ask for them
+	void PreloadTextures(const aiScene* scene, std::string path);
+	Mesh LoadMesh(aiMesh* mesh, const aiScene* scene, std::string path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
 	std::vector<Texture> LoadMaterialTextures(aiMaterial* mat, aiTextureType type, Texture::TextureType myType, std::string path);
 };
\ No newline at end of file
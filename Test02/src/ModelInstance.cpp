@@ -9,118 +9,142 @@ using glm::vec3;
 using glm::vec4;
 using glm::mat4;
 
+//Meshes don't carry a shininess of their own yet
+#define DEFAULT_SHININESS 32.f
+
 static vec3 lightPosition;
 static vec3 lightDiffuseColor;
 static vec3 lightSpecularColor;
 static vec3 lightAmbientColor;
 static vec3 lightAttenuation;
+static vec3 lightDirection(0.f, -1.f, 0.f);
+static float lightCutoff = -1.f;
+static float lightCutoffInner = 1.f;
 
-ModelInstance::ModelInstance(Model* model, unsigned int shader)
+ModelInstance::ModelInstance(Model* model, ShaderVariant shader)
 {
 	this->model = model;
 	this->shader = shader;
-	scale = vec3(1.f);
-	transform = mat4(1.f);
-	SetUniformAddresses();
+	program = 0;
+	transform = CreateTransform(NO_TRANSFORM);
 }
 
-ModelInstance::ModelInstance(Model* model, unsigned int shader, glm::vec3 position)
+ModelInstance::ModelInstance(Model* model, ShaderVariant shader, glm::vec3 position)
 {
 	this->model = model;
 	this->shader = shader;
-	scale = vec3(1.f);
+	program = 0;
+	transform = CreateTransform(NO_TRANSFORM);
 	SetPosition(position);
-	SetUniformAddresses();
 }
 
-ModelInstance::ModelInstance(Model* model, unsigned int shader, glm::vec3 position, glm::vec3 eulerRotation, glm::vec3 scale)
+ModelInstance::ModelInstance(Model* model, ShaderVariant shader, glm::vec3 position, glm::vec3 eulerRotation, glm::vec3 scale)
 {
 	this->model = model;
 	this->shader = shader;
+	program = 0;
+	transform = CreateTransform(NO_TRANSFORM);
 	SetPosition(position);
 	SetRotation(eulerRotation);
 	SetScale(scale);
-	SetUniformAddresses();
 }
 
 void ModelInstance::SetUniformAddresses()
 {
-	modelUniform = glGetUniformLocation(shader, "model");
-	viewUniform = glGetUniformLocation(shader, "view");
-	projectionUniform = glGetUniformLocation(shader, "projection");
-	viewPositionUniform = glGetUniformLocation(shader, "viewPos");
-	nearUniform = glGetUniformLocation(shader, "near");
-	farUniform = glGetUniformLocation(shader, "far");
+	modelUniform = glGetUniformLocation(program, "model");
+	modelNormalUniform = glGetUniformLocation(program, "modelNormal");
+	viewUniform = glGetUniformLocation(program, "view");
+	projectionUniform = glGetUniformLocation(program, "projection");
+	viewPositionUniform = glGetUniformLocation(program, "viewPos");
+	nearUniform = glGetUniformLocation(program, "near");
+	farUniform = glGetUniformLocation(program, "far");
+
+	diffuseMapUniform = glGetUniformLocation(program, "material.diffuseMap");
+	specularMapUniform = glGetUniformLocation(program, "material.specularMap");
+	shininessUniform = glGetUniformLocation(program, "material.shininess");
 
-	diffuseMapUniform = glGetUniformLocation(shader, "material.diffuseMap");
-	specularMapUniform = glGetUniformLocation(shader, "material.specularMap");
-	shininessUniform = glGetUniformLocation(shader, "material.shininess");
+	lightPositionUniform = glGetUniformLocation(program, "light.position");
+	lightAmbientUniform = glGetUniformLocation(program, "light.ambient");
+	lightDiffuseUniform = glGetUniformLocation(program, "light.diffuse");
+	lightSpecularUniform = glGetUniformLocation(program, "light.specular");
+	lightAttenConstantUniform = glGetUniformLocation(program, "light.attenConstant");
+	lightAttenLinearUniform = glGetUniformLocation(program, "light.attenLinear");
+	lightAttenQuadraticUniform = glGetUniformLocation(program, "light.attenQuadratic");
+	lightDirectionUniform = glGetUniformLocation(program, "light.direction");
+	lightCutoffUniform = glGetUniformLocation(program, "light.cutoff");
+	lightCutoffInnerUniform = glGetUniformLocation(program, "light.cutoffInner");
 
-	lightPositionUniform = glGetUniformLocation(shader, "light.position");
-	lightAmbientUniform = glGetUniformLocation(shader, "light.ambient");
-	lightDiffuseUniform = glGetUniformLocation(shader, "light.diffuse");
-	lightSpecularUniform = glGetUniformLocation(shader, "light.specular");
-	lightAttenConstantUniform = glGetUniformLocation(shader, "light.attenConstant");
-	lightAttenLinearUniform = glGetUniformLocation(shader, "light.attenLinear");
-	lightAttenQuadraticUniform = glGetUniformLocation(shader, "light.attenQuadratic");
+	lightClusterUniforms = GetLightClusterUniforms(program);
 }
 
-void ModelInstance::SetShader(unsigned int shader)
+void ModelInstance::SetShader(ShaderVariant shader)
 {
 	this->shader = shader;
-	SetUniformAddresses();
 }
 
-unsigned int ModelInstance::GetShader()
+ShaderVariant ModelInstance::GetShader()
 {
 	return shader;
 }
 
 void ModelInstance::SetPosition(glm::vec3 position)
 {
-	this->position = position;
-	UpdateTransform();
+	SetTransformPosition(transform, position);
 }
 
 void ModelInstance::SetRotation(glm::vec3 eulerRotation)
 {
-	this->eulerRotation = eulerRotation;
-	UpdateTransform();
+	SetTransformRotation(transform, eulerRotation);
 }
 
 void ModelInstance::SetScale(glm::vec3 scale)
 {
-	this->scale = scale;
-	UpdateTransform();
-}
-
-void ModelInstance::UpdateTransform()
-{
-	transform = mat4(1.f);
-	transform = glm::translate(transform, position);
-	transform = glm::scale(transform, scale);
-	transform *= glm::eulerAngleYXZ(glm::radians(eulerRotation.y), glm::radians(eulerRotation.x), glm::radians(eulerRotation.z));
+	SetTransformScale(transform, scale);
 }
 
 glm::vec3 ModelInstance::GetPosition()
 {
-	return position;
+	return GetTransformPosition(transform);
 }
 
 glm::vec3 ModelInstance::GetRotation()
 {
-	return eulerRotation;
+	return GetTransformRotation(transform);
 }
 
 glm::vec3 ModelInstance::GetScale()
 {
-	return scale;
+	return GetTransformScale(transform);
+}
+
+Transform ModelInstance::GetTransform()
+{
+	return transform;
+}
+
+void ModelInstance::SetParent(Transform parent)
+{
+	SetTransformParent(transform, parent);
 }
 
 void ModelInstance::Draw()
 {
+	//Build the variant on first use and refetch uniform addresses whenever the program changes
+	unsigned int currentProgram = GetShaderVariantProgram(shader);
+
+	if (currentProgram == (unsigned int)-1)
+	{
+		return;
+	}
+
+	if (currentProgram != program)
+	{
+		program = currentProgram;
+		SetUniformAddresses();
+	}
+
 	//Lighting uniforms
-	glUseProgram(shader);
+	glUseProgram(program);
 
 	if (lightPositionUniform != -1) glUniform3f(lightPositionUniform, lightPosition.x, lightPosition.y, lightPosition.z);
 	if (lightDiffuseUniform != -1) glUniform3f(lightDiffuseUniform, lightDiffuseColor.x, lightDiffuseColor.y, lightDiffuseColor.z);
@@ -129,19 +153,27 @@ void ModelInstance::Draw()
 	if (lightAttenConstantUniform != -1) glUniform1f(lightAttenConstantUniform, lightAttenuation.x);
 	if (lightAttenLinearUniform != -1) glUniform1f(lightAttenLinearUniform, lightAttenuation.y);
 	if (lightAttenQuadraticUniform != -1) glUniform1f(lightAttenQuadraticUniform, lightAttenuation.z);
-
-	//Transformation and Camera uniforms
-	if (viewUniform != -1) glUniformMatrix4fv(viewUniform, 1, GL_FALSE, glm::value_ptr(GetCameraView()));
-	if (projectionUniform != -1) glUniformMatrix4fv(projectionUniform, 1, GL_FALSE, glm::value_ptr(GetCameraProjection()));
-	if (modelUniform != -1) glUniformMatrix4fv(modelUniform, 1, GL_FALSE, glm::value_ptr(transform));
-	vec3 camPos = GetCameraPosition();
+	if (lightDirectionUniform != -1) glUniform3f(lightDirectionUniform, lightDirection.x, lightDirection.y, lightDirection.z);
+	if (lightCutoffUniform != -1) glUniform1f(lightCutoffUniform, lightCutoff);
+	if (lightCutoffInnerUniform != -1) glUniform1f(lightCutoffInnerUniform, lightCutoffInner);
+	ApplyLightClusters(lightClusterUniforms);
+
+	//Transformation and Camera uniforms, the camera only rebuilds its matrices after it changes
+	Camera* camera = GetActiveCamera();
+	if (viewUniform != -1) glUniformMatrix4fv(viewUniform, 1, GL_FALSE, glm::value_ptr(camera->GetView()));
+	if (projectionUniform != -1) glUniformMatrix4fv(projectionUniform, 1, GL_FALSE, glm::value_ptr(camera->GetProjection()));
+	vec3 camPos = camera->GetPosition();
 	if (viewPositionUniform != -1) glUniform3f(viewPositionUniform, camPos.x, camPos.y, camPos.z);
-	if (nearUniform != -1)  glUniform1f(nearUniform, GetCameraNear());
-	if (farUniform != -1)  glUniform1f(farUniform, GetCameraFar());
+	if (nearUniform != -1)  glUniform1f(nearUniform, camera->GetNear());
+	if (farUniform != -1)  glUniform1f(farUniform, camera->GetFar());
 
-	//Draw model, this will also assign texture maps
+	//Material uniforms
+	if (shininessUniform != -1) glUniform1f(shininessUniform, DEFAULT_SHININESS);
+
+	//Draw model, this will also assign texture maps and the model matrix of each mesh.
+	//The normal matrix comes from the transform hierarchy, only rebuilt when the transform moves
 	//glUseProgram(shader);
-	model->Draw(shader);
+	model->Draw(program, modelUniform, GetWorldTransform(transform), modelNormalUniform, GetWorldNormalMatrix(transform));
 }
 
 void SetLightPosition(glm::vec3 position)
@@ -161,3 +193,9 @@ void SetLightAttenuation(float constant, float linear, float quadratic)
 	lightAttenuation = vec3(constant, linear, quadratic);
 }
 
+void SetLightSpot(glm::vec3 direction, float innerAngle, float outerAngle)
+{
+	lightDirection = glm::normalize(direction);
+	lightCutoffInner = cos(glm::radians(innerAngle));
+	lightCutoff = cos(glm::radians(outerAngle));
+}
\ No newline at end of file
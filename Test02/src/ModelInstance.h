@@ -2,21 +2,24 @@
 #include <vector>
 #include "glm/glm.hpp"
 #include "Model.h"
+#include "LightManager.h"
+#include "Shader.h"
+#include "Transform.h"
 
 class ModelInstance
 {
 private:
 	Model* model;
-	unsigned int shader;
+	ShaderVariant shader;
+	//Program the uniform addresses below belong to, resolved on draw so unused variants never compile
+	unsigned int program;
 
-	//Transform
-	glm::mat4 transform;
-	glm::vec3 position;
-	glm::vec3 eulerRotation;
-	glm::vec3 scale;
+	//Node in the transform hierarchy, copies of an instance share it
+	Transform transform;
 
 	//Shader addresses
 	unsigned int modelUniform;
+	unsigned int modelNormalUniform;
 	unsigned int viewUniform;
 	unsigned int projectionUniform;
 	unsigned int viewPositionUniform;
@@ -34,17 +37,21 @@ private:
 	unsigned int lightAttenConstantUniform;
 	unsigned int lightAttenLinearUniform;
 	unsigned int lightAttenQuadraticUniform;
+	unsigned int lightDirectionUniform;
+	unsigned int lightCutoffUniform;
+	unsigned int lightCutoffInnerUniform;
+
+	LightClusterUniforms lightClusterUniforms;
 
 	void SetUniformAddresses();
-	void UpdateTransform();
 
 public:
-	ModelInstance(Model* model, unsigned int shader);
-	ModelInstance(Model* model, unsigned int shader, glm::vec3 position);
-	ModelInstance(Model* model, unsigned int shader, glm::vec3 position, glm::vec3 eulerRotation, glm::vec3 scale);
+	ModelInstance(Model* model, ShaderVariant shader);
+	ModelInstance(Model* model, ShaderVariant shader, glm::vec3 position);
+	ModelInstance(Model* model, ShaderVariant shader, glm::vec3 position, glm::vec3 eulerRotation, glm::vec3 scale);
 
-	void SetShader(unsigned int shader);
-	unsigned int GetShader();
+	void SetShader(ShaderVariant shader);
+	ShaderVariant GetShader();
 
 	void SetPosition(glm::vec3 position);
 	void SetRotation(glm::vec3 eulerRotation);
@@ -54,6 +61,9 @@ public:
 	glm::vec3 GetRotation();
 	glm::vec3 GetScale();
 
+	Transform GetTransform();
+	void SetParent(Transform parent);
+
 	void Draw();
 
 };
@@ -61,3 +71,5 @@ public:
 void SetLightPosition(glm::vec3 position);
 void SetLightColor(glm::vec3 diffuse, glm::vec3 specular, glm::vec3 ambient);
 void SetLightAttenuation(float constant, float linear, float quadratic);
+//Cone for the SPOT_LIGHT variant, angles in degrees from the direction
+void SetLightSpot(glm::vec3 direction, float innerAngle, float outerAngle);
@@ -0,0 +1,118 @@
+#include <glad.h>
+#include <iostream>
+#include "SceneBuffer.h"
+
+static DepthMode depthMode = StandardDepth;
+
+//Offscreen target, only used for reverse depth with clip control
+static unsigned int framebuffer = 0;
+static unsigned int colorBuffer = 0;
+static unsigned int depthBuffer = 0;
+static unsigned int bufferWidth = 0;
+static unsigned int bufferHeight = 0;
+
+//Drawn into when there is no scene buffer and presented to when there is
+static unsigned int outputFramebuffer = 0;
+
+static void CreateFramebuffer(unsigned int width, unsigned int height)
+{
+	bufferWidth = width;
+	bufferHeight = height;
+
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	//Float depth keeps its precision all the way out when depth falls towards 0, stencil is kept for outlines
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH32F_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Scene framebuffer incomplete, drawing to the window instead\n";
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		CleanupSceneBuffer();
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void InitializeSceneBuffer(DepthMode mode, unsigned int width, unsigned int height)
+{
+	depthMode = mode;
+
+	if (mode == StandardDepth)
+	{
+		glDepthFunc(GL_LESS);
+		glClearDepth(1.0);
+		return;
+	}
+
+	//glad only loads glClipControl on 4.5 contexts. Without it NDC depth still maps -1..1 to 0..1,
+	//reversing then still works but leaves only half the range so a float buffer gains nothing.
+	if (glClipControl != nullptr)
+	{
+		glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+		CreateFramebuffer(width, height);
+	}
+
+	glDepthFunc(GL_GREATER);
+	glClearDepth(0.0);
+}
+
+void ResizeSceneBuffer(unsigned int width, unsigned int height)
+{
+	if (framebuffer == 0 || width == 0 || height == 0 || (width == bufferWidth && height == bufferHeight))
+	{
+		return;
+	}
+
+	CleanupSceneBuffer();
+	CreateFramebuffer(width, height);
+}
+
+DepthMode GetSceneDepthMode()
+{
+	return depthMode;
+}
+
+void SetSceneOutput(unsigned int framebuffer)
+{
+	outputFramebuffer = framebuffer;
+}
+
+void BindSceneBuffer()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer != 0 ? framebuffer : outputFramebuffer);
+}
+
+void PresentSceneBuffer()
+{
+	if (framebuffer == 0)
+	{
+		return;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+	glBlitFramebuffer(0, 0, bufferWidth, bufferHeight, 0, 0, bufferWidth, bufferHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+}
+
+void CleanupSceneBuffer()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+}
\ No newline at end of file
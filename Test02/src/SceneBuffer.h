@@ -0,0 +1,20 @@
+#pragma once
+
+//Depth conventions the scene can be drawn with
+enum DepthMode { StandardDepth, ReverseDepth };
+
+//Reverse depth stores 1 at the near plane falling towards 0 at infinity and tests with GL_GREATER.
+//Where clip control is available the scene is drawn into a float depth buffer and copied to the window,
+//otherwise it draws straight into the window's framebuffer.
+void InitializeSceneBuffer(DepthMode mode, unsigned int width, unsigned int height);
+void ResizeSceneBuffer(unsigned int width, unsigned int height);
+DepthMode GetSceneDepthMode();
+
+//Where the scene ends up, the window's framebuffer unless it is replaced with an offscreen one
+void SetSceneOutput(unsigned int framebuffer);
+
+//Binds the framebuffer the scene is drawn into
+void BindSceneBuffer();
+//Copies the scene to the output framebuffer
+void PresentSceneBuffer();
+void CleanupSceneBuffer();
\ No newline at end of file
@@ -6,16 +6,110 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <thread>
 #include "Shader.h"
+#include "Profiler.h"
+#include "JobSystem.h"
 
 using std::string;
 using std::ifstream;
 using std::stringstream;
 
+//Linked programs are saved here, keyed by a hash of their sources, defines and the driver
+#define SHADER_CACHE_DIRECTORY "shadercache"
+#define SHADER_CACHE_MAGIC 0x42504853
+
+//How often ReloadChangedShaders looks at the files on disk
+#define SHADER_WATCH_INTERVAL_MS 250
+
+//From KHR_parallel_shader_compile, glad was generated without extensions
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 static std::vector<int> vertShaders;
 static std::vector<int> fragShaders;
 static std::vector<int> shaderPrograms;
 
+enum VariantState { VariantUnrequested, VariantLoading, VariantLinking, VariantReady, VariantFailed };
+
+//Sources and any cached binary of a variant, read by a job
+struct VariantSources
+{
+	bool loaded;
+	string vertSource, fragSource;
+	//Every file each stage was read from, the stage's own file first, in #line source string order
+	std::vector<string> vertFiles, fragFiles;
+	unsigned long long key;
+	unsigned int binaryFormat;
+	std::vector<char> binary;
+};
+
+//A load in flight, the sources stay here until the main thread takes them once read is done
+struct VariantLoad
+{
+	JobCounter read;
+	VariantSources sources;
+};
+
+struct ShaderVariantInfo
+{
+	string vertPath, fragPath, defines;
+	VariantState state;
+	std::unique_ptr<VariantLoad> load;
+	VariantSources sources;
+	//The program being drawn with, 0 before the first successful build
+	unsigned int program;
+	//The program being built, replaces program once it links
+	unsigned int building;
+	unsigned int vertShader, fragShader;
+	bool fromBinary;
+	//A file changed while this variant was already building
+	bool reloadQueued;
+};
+
+static std::vector<ShaderVariantInfo> variants;
+static std::map<string, ShaderVariant> variantLookup;
+static unsigned int liveVariantCount = 0;
+
+//Drawn in place of variants that are still building or failed to build
+static unsigned int fallbackProgram = -1;
+static bool parallelCompileSupported = false;
+//Variant loads and cache writes still running, the objects they use have to stay until these are done
+static JobCounter shaderJobs;
+
+//Dependency graph, every file a built variant was read from and the variants that read it
+static std::map<string, std::filesystem::file_time_type> watchedFiles;
+static std::map<string, std::vector<ShaderVariant>> fileDependents;
+static std::chrono::steady_clock::time_point lastWatchTime;
+
+static const char* fallbackVertSource =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 in_pos;\n"
+	"layout (location = 3) in mat3x4 in_node;\n"
+	"uniform mat3x4 model;\n"
+	"uniform mat4 view;\n"
+	"uniform mat4 projection;\n"
+	"void main()\n"
+	"{\n"
+	"	vec3 worldPos = vec4(vec4(in_pos, 1.0) * in_node, 1.0) * model;\n"
+	"	gl_Position = projection * view * vec4(worldPos, 1.0);\n"
+	"}\n";
+
+static const char* fallbackFragSource =
+	"#version 330 core\n"
+	"out vec4 frag_color;\n"
+	"void main()\n"
+	"{\n"
+	"	frag_color = vec4(0.5, 0.5, 0.5, 1.0);\n"
+	"}\n";
+
 static bool ShaderSuccess(unsigned int shaderID)
 {
 	int success;
@@ -30,10 +124,44 @@ static bool ProgramSuccess(unsigned int programID)
 	return success == GL_TRUE;
 }
 
+//Adds a #define line per name after the #version line, #line keeps error line numbers matching the file
+static string InsertDefines(const string& source, const char* defines)
+{
+	stringstream names(defines);
+	string name;
+	string lines;
+
+	while (names >> name)
+	{
+		lines += "#define " + name + "\n";
+	}
+
+	size_t version = source.find("#version");
+
+	if (version == string::npos)
+	{
+		return lines + "#line 1\n" + source;
+	}
+
+	size_t lineEnd = source.find('\n', version);
+
+	if (lineEnd == string::npos)
+	{
+		return source + "\n" + lines;
+	}
+
+	size_t nextLine = std::count(source.begin(), source.begin() + lineEnd, '\n') + 2;
+	return source.substr(0, lineEnd + 1) + lines + "#line " + std::to_string(nextLine) + "\n" + source.substr(lineEnd + 1);
+}
+
 unsigned int CreateShader(ShaderType type, const char* filePath)
+{
+	return CreateShader(type, filePath, "");
+}
+
+static bool ReadFile(const string& filePath, string& data)
 {
 	//Read file
-	string data;
 	ifstream file;
 
 	//Ensure ifstream can throw exceptions
@@ -57,25 +185,126 @@ unsigned int CreateShader(ShaderType type, const char* filePath)
 	}
 	catch (ifstream::failure e)
 	{
-		std::cout << "File read failed!\n";
-		return -1;
+		std::cout << "File read failed! " << filePath << "\n";
+		return false;
 	}
 
+	return true;
+}
+
+//Replaces #include "file" lines with the file, paths are relative to the including file and each file is included once.
+//#line directives number every file as its own source string, in the order they appear in files.
+static bool ExpandIncludes(const string& filePath, const string& source, std::vector<string>& files, string& output)
+{
+	size_t fileNumber = std::find(files.begin(), files.end(), filePath) - files.begin();
+	stringstream lines(source);
+	string line;
+	int lineNumber = 0;
+
+	while (std::getline(lines, line))
+	{
+		lineNumber++;
+		size_t start = line.find_first_not_of(" \t");
+
+		if (start == string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			output += line + "\n";
+			continue;
+		}
+
+		size_t open = line.find('"', start);
+		size_t close = open == string::npos ? string::npos : line.find('"', open + 1);
+
+		if (close == string::npos)
+		{
+			std::cout << "Bad #include in " << filePath << " line " << lineNumber << "\n";
+			return false;
+		}
+
+		string includePath = (std::filesystem::path(filePath).parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal().generic_string();
+
+		if (std::find(files.begin(), files.end(), includePath) != files.end())
+		{
+			output += "\n";
+			continue;
+		}
+
+		string included;
+		files.push_back(includePath);
+
+		if (!ReadFile(includePath, included))
+		{
+			return false;
+		}
+
+		output += "#line 1 " + std::to_string(files.size() - 1) + "\n";
+
+		if (!ExpandIncludes(includePath, included, files, output))
+		{
+			return false;
+		}
+
+		output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileNumber) + "\n";
+	}
+
+	return true;
+}
+
+//Reads a shader file, expands its includes and inserts the variant defines
+static bool ReadShaderSource(const char* filePath, const char* defines, string& data, std::vector<string>& files)
+{
+	string path = std::filesystem::path(filePath).lexically_normal().generic_string();
+	string source;
+	files.assign(1, path);
+	data.clear();
+
+	if (!ReadFile(path, source) || !ExpandIncludes(path, source, files, data))
+	{
+		return false;
+	}
+
+	if (defines[0] != '\0')
+	{
+		data = InsertDefines(data, defines);
+	}
+
+	return true;
+}
+
+//Hands a shader to the driver without waiting for the result
+static unsigned int SubmitShader(ShaderType type, const string& data)
+{
 	const char* source = data.c_str();
 
 	unsigned int id = glCreateShader(type == VertShader ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
 	glShaderSource(id, 1, &source, nullptr);
 	glCompileShader(id);
+	return id;
+}
 
-	//Check if shaders compiled successfully
+//Waits for the compile if it is still running, prints the log on failure.
+//Log lines start with the source string number, files maps those back to paths.
+static bool CheckShader(unsigned int id, ShaderType type, const std::vector<string>& files, const char* defines)
+{
 	if (!ShaderSuccess(id))
 	{
 		char infoLog[512];
 		glGetShaderInfoLog(id, 512, nullptr, infoLog);
-		std::cout << (type == VertShader ? "Vertex" : "Fragment") << "Shader compilation failed! LOG: " << infoLog << "\n";
-		return -1;
+		std::cout << (type == VertShader ? "Vertex" : "Fragment") << "Shader compilation failed! " << files[0] << " [" << defines << "] LOG: " << infoLog << "\n";
+
+		for (size_t i = 1; i < files.size(); i++)
+		{
+			std::cout << "  source " << i << ": " << files[i] << "\n";
+		}
+
+		return false;
 	}
 
+	return true;
+}
+
+static void RegisterShader(unsigned int id, ShaderType type)
+{
 	if (type == VertShader)
 	{
 		vertShaders.push_back(id);
@@ -86,10 +315,196 @@ unsigned int CreateShader(ShaderType type, const char* filePath)
 		fragShaders.push_back(id);
 		std::cout << "Created Fragment Shader: " << id << "\n";
 	}
+}
+
+static unsigned int CompileShader(ShaderType type, const string& data, const std::vector<string>& files, const char* defines)
+{
+	PROFILE_SCOPE("Compile shader");
+	unsigned int id = SubmitShader(type, data);
+
+	//Check if shaders compiled successfully
+	if (!CheckShader(id, type, files, defines))
+	{
+		return -1;
+	}
 
+	RegisterShader(id, type);
 	return id;
 }
 
+unsigned int CreateShader(ShaderType type, const char* filePath, const char* defines)
+{
+	string data;
+	std::vector<string> files;
+
+	if (!ReadShaderSource(filePath, defines, data, files))
+	{
+		return -1;
+	}
+
+	return CompileShader(type, data, files, defines);
+}
+
+//Program binaries need GL 4.1 or ARB_get_program_binary, and at least one format from the driver
+static bool ProgramBinarySupported()
+{
+	static int supported = -1;
+
+	if (supported == -1)
+	{
+		int formats = 0;
+
+		if (glGetProgramBinary != nullptr && glProgramBinary != nullptr && glProgramParameteri != nullptr)
+		{
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		}
+
+		supported = formats > 0 ? 1 : 0;
+	}
+
+	return supported == 1;
+}
+
+//FNV-1a, each part is followed by a zero byte so neighbouring parts can't run into each other
+static unsigned long long HashPart(unsigned long long hash, const char* data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		hash = (hash ^ (unsigned char)data[i]) * 0x100000001b3ull;
+	}
+
+	return hash * 0x100000001b3ull;
+}
+
+//A driver update can change what a binary means, so its strings are part of the cache key
+static const string& GetDriverString()
+{
+	static string driver;
+
+	if (driver.empty())
+	{
+		const char* parts[3] = { (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION) };
+
+		for (const char* part : parts)
+		{
+			driver += string(part != nullptr ? part : "") + "\n";
+		}
+	}
+
+	return driver;
+}
+
+static unsigned long long HashProgram(const string& driver, const string& vertSource, const string& fragSource, const char* defines)
+{
+	unsigned long long hash = HashPart(0xcbf29ce484222325ull, driver.data(), driver.size());
+	hash = HashPart(hash, vertSource.data(), vertSource.size());
+	hash = HashPart(hash, fragSource.data(), fragSource.size());
+	return HashPart(hash, defines, strlen(defines));
+}
+
+static string ProgramCachePath(unsigned long long key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", key);
+	return string(SHADER_CACHE_DIRECTORY) + "/" + name;
+}
+
+//File side of the cache, no GL calls so it can run on a worker
+static bool ReadProgramBinary(unsigned long long key, unsigned int& format, std::vector<char>& binary)
+{
+	ifstream file(ProgramCachePath(key), std::ios::binary);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	unsigned int header[3];
+	file.read((char*)header, sizeof(header));
+
+	if (!file || header[0] != SHADER_CACHE_MAGIC)
+	{
+		return false;
+	}
+
+	format = header[1];
+	binary.resize(header[2]);
+	file.read(binary.data(), binary.size());
+
+	if (!file)
+	{
+		binary.clear();
+		return false;
+	}
+
+	return true;
+}
+
+static void WriteProgramBinary(unsigned long long key, unsigned int format, std::vector<char> binary)
+{
+	std::error_code error;
+	std::filesystem::create_directories(SHADER_CACHE_DIRECTORY, error);
+
+	std::ofstream file(ProgramCachePath(key), std::ios::binary);
+	unsigned int header[3] = { SHADER_CACHE_MAGIC, format, (unsigned int)binary.size() };
+	file.write((const char*)header, sizeof(header));
+	file.write(binary.data(), binary.size());
+
+	if (!file)
+	{
+		std::cout << "Failed to write shader cache " << ProgramCachePath(key) << "\n";
+	}
+}
+
+//Returns 0 when there is no cached binary or the driver refuses it
+static unsigned int LoadProgramBinary(unsigned long long key)
+{
+	unsigned int format;
+	std::vector<char> binary;
+
+	if (!ReadProgramBinary(key, format, binary))
+	{
+		return 0;
+	}
+
+	unsigned int programID = glCreateProgram();
+	glProgramBinary(programID, format, binary.data(), (int)binary.size());
+
+	if (!ProgramSuccess(programID))
+	{
+		glDeleteProgram(programID);
+		return 0;
+	}
+
+	return programID;
+}
+
+//Fetches the binary from the driver, the file is written here or by a job when async is set
+static void SaveProgramBinary(unsigned long long key, unsigned int programID, bool async)
+{
+	int length = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(length);
+	unsigned int format;
+	glGetProgramBinary(programID, length, &length, &format, binary.data());
+	binary.resize(length);
+
+	if (async)
+	{
+		RunJob([key, format, binary = std::move(binary)] { WriteProgramBinary(key, format, binary); }, &shaderJobs);
+	}
+	else
+	{
+		WriteProgramBinary(key, format, std::move(binary));
+	}
+}
+
 unsigned int CreateShaderProgram(unsigned int vertShaderID, unsigned int fragShaderID)
 {
 #ifdef _DEBUG
@@ -106,7 +521,14 @@ unsigned int CreateShaderProgram(unsigned int vertShaderID, unsigned int fragSha
 #endif
 
 	//Set up shader program
+	PROFILE_SCOPE("Link shader program");
 	unsigned int programID = glCreateProgram();
+
+	if (ProgramBinarySupported())
+	{
+		glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
 	glAttachShader(programID, vertShaderID);
 	glAttachShader(programID, fragShaderID);
 	glLinkProgram(programID);
@@ -126,11 +548,437 @@ unsigned int CreateShaderProgram(unsigned int vertShaderID, unsigned int fragSha
 
 unsigned int CreateShaderProgram(const char* vertShaderPath, const char* fragShaderPath)
 {
-	return CreateShaderProgram(CreateShader(VertShader, vertShaderPath), CreateShader(FragShader, fragShaderPath));
+	return CreateShaderProgram(vertShaderPath, fragShaderPath, "");
+}
+
+unsigned int CreateShaderProgram(const char* vertShaderPath, const char* fragShaderPath, const char* defines)
+{
+	string vertSource, fragSource;
+	std::vector<string> vertFiles, fragFiles;
+
+	if (!ReadShaderSource(vertShaderPath, defines, vertSource, vertFiles) || !ReadShaderSource(fragShaderPath, defines, fragSource, fragFiles))
+	{
+		return -1;
+	}
+
+	//Skip compiling entirely when this exact program was linked by this driver before
+	bool useCache = ProgramBinarySupported();
+	unsigned long long key = useCache ? HashProgram(GetDriverString(), vertSource, fragSource, defines) : 0;
+
+	if (useCache)
+	{
+		unsigned int programID = LoadProgramBinary(key);
+
+		if (programID != 0)
+		{
+			shaderPrograms.push_back(programID);
+			std::cout << "Loaded cached Shader Program: " << programID << "\n";
+			return programID;
+		}
+	}
+
+	unsigned int programID = CreateShaderProgram(CompileShader(VertShader, vertSource, vertFiles, defines), CompileShader(FragShader, fragSource, fragFiles, defines));
+
+	if (useCache && programID != (unsigned int)-1)
+	{
+		SaveProgramBinary(key, programID, false);
+	}
+
+	return programID;
+}
+
+//Sorted and without repeats, so "A B", "B A" and "A A B" all name the same permutation
+static string NormalizeDefines(const char* defines)
+{
+	stringstream stream(defines);
+	std::vector<string> names;
+	string name;
+
+	while (stream >> name)
+	{
+		names.push_back(name);
+	}
+
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+
+	string normalized;
+
+	for (const string& n : names)
+	{
+		normalized += (normalized.empty() ? "" : " ") + n;
+	}
+
+	return normalized;
+}
+
+ShaderVariant GetShaderVariant(const char* vertShaderPath, const char* fragShaderPath, const char* defines)
+{
+	string normalized = NormalizeDefines(defines);
+	string key = string(vertShaderPath) + "\n" + fragShaderPath + "\n" + normalized;
+	std::map<string, ShaderVariant>::iterator found = variantLookup.find(key);
+
+	if (found != variantLookup.end())
+	{
+		return found->second;
+	}
+
+	ShaderVariant variant = (ShaderVariant)variants.size();
+	variants.push_back(ShaderVariantInfo());
+	ShaderVariantInfo& info = variants.back();
+	info.vertPath = vertShaderPath;
+	info.fragPath = fragShaderPath;
+	info.defines = normalized;
+	info.state = VariantUnrequested;
+	info.program = 0;
+	info.building = 0;
+	info.reloadQueued = false;
+	variantLookup[key] = variant;
+	return variant;
+}
+
+void InitializeShaders()
+{
+	//Lets the driver compile on its own threads, and us ask whether it is done without blocking
+	int extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+	for (int i = 0; i < extensionCount; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+
+		if (strcmp(extension, "GL_KHR_parallel_shader_compile") == 0 || strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+		{
+			parallelCompileSupported = true;
+		}
+	}
+
+	std::vector<string> fallbackFiles(1, "fallback");
+	fallbackProgram = CreateShaderProgram(CompileShader(VertShader, fallbackVertSource, fallbackFiles, ""), CompileShader(FragShader, fallbackFragSource, fallbackFiles, ""));
+	lastWatchTime = std::chrono::steady_clock::now();
+}
+
+//Runs as a job, everything but the GL calls
+static VariantSources LoadVariantSources(string vertPath, string fragPath, string defines, string driver, bool useCache)
+{
+	PROFILE_SCOPE("Load shader variant sources");
+	VariantSources sources;
+	sources.loaded = ReadShaderSource(vertPath.c_str(), defines.c_str(), sources.vertSource, sources.vertFiles) && ReadShaderSource(fragPath.c_str(), defines.c_str(), sources.fragSource, sources.fragFiles);
+	sources.key = 0;
+	sources.binaryFormat = 0;
+
+	if (sources.loaded && useCache)
+	{
+		sources.key = HashProgram(driver, sources.vertSource, sources.fragSource, defines.c_str());
+		ReadProgramBinary(sources.key, sources.binaryFormat, sources.binary);
+	}
+
+	return sources;
+}
+
+//Starts the compile and link, the results are only looked at on a later update
+static void SubmitVariant(ShaderVariantInfo& info)
+{
+	PROFILE_SCOPE("Submit shader variant");
+	info.building = glCreateProgram();
+	info.vertShader = 0;
+	info.fragShader = 0;
+	info.fromBinary = !info.sources.binary.empty();
+
+	if (info.fromBinary)
+	{
+		glProgramBinary(info.building, info.sources.binaryFormat, info.sources.binary.data(), (int)info.sources.binary.size());
+	}
+	else
+	{
+		info.vertShader = SubmitShader(VertShader, info.sources.vertSource);
+		info.fragShader = SubmitShader(FragShader, info.sources.fragSource);
+
+		if (ProgramBinarySupported())
+		{
+			glProgramParameteri(info.building, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
+		glAttachShader(info.building, info.vertShader);
+		glAttachShader(info.building, info.fragShader);
+		glLinkProgram(info.building);
+	}
+
+	info.state = VariantLinking;
+}
+
+//Without the extension every status query blocks, so it is put off until the update after submitting
+static bool LinkComplete(unsigned int program)
+{
+	if (!parallelCompileSupported)
+	{
+		return true;
+	}
+
+	int complete = GL_FALSE;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+//Records which files a variant was read from, so edits to any of them rebuild it
+static void WatchVariantFiles(ShaderVariant variant, const VariantSources& sources)
+{
+	std::vector<string> files = sources.vertFiles;
+	files.insert(files.end(), sources.fragFiles.begin(), sources.fragFiles.end());
+
+	for (const string& file : files)
+	{
+		std::vector<ShaderVariant>& dependents = fileDependents[file];
+
+		if (std::find(dependents.begin(), dependents.end(), variant) == dependents.end())
+		{
+			dependents.push_back(variant);
+		}
+
+		if (watchedFiles.find(file) == watchedFiles.end())
+		{
+			std::error_code error;
+			watchedFiles[file] = std::filesystem::last_write_time(file, error);
+		}
+	}
+}
+
+//A variant that already has a program keeps it when a rebuild fails
+static void EndFailedBuild(ShaderVariantInfo& info)
+{
+	info.state = info.program != 0 ? VariantReady : VariantFailed;
+	info.building = 0;
+	info.sources = VariantSources();
+	std::cout << "Failed to build shader variant " << info.fragPath << " [" << info.defines << "]" << (info.program != 0 ? ", keeping the previous program\n" : "\n");
+}
+
+//Runs on the main thread once the sources are read, hands them to the driver
+static void SubmitLoadedVariant(ShaderVariant variant)
+{
+	ShaderVariantInfo& info = variants[(size_t)variant];
+	info.sources = std::move(info.load->sources);
+	info.load.reset();
+
+	if (info.sources.loaded)
+	{
+		SubmitVariant(info);
+	}
+	else
+	{
+		WatchVariantFiles(variant, info.sources);
+		EndFailedBuild(info);
+	}
+}
+
+static void StartLoadingVariant(ShaderVariant variant)
+{
+	ShaderVariantInfo& info = variants[(size_t)variant];
+	info.state = VariantLoading;
+	info.reloadQueued = false;
+
+	//Held apart from the variant, which can move while the job runs
+	info.load = std::make_unique<VariantLoad>();
+	VariantLoad* load = info.load.get();
+	string vertPath = info.vertPath, fragPath = info.fragPath, defines = info.defines, driver = GetDriverString();
+	bool useCache = ProgramBinarySupported();
+
+	RunJob([load, vertPath, fragPath, defines, driver, useCache] { load->sources = LoadVariantSources(vertPath, fragPath, defines, driver, useCache); }, &load->read);
+	RunOnMainThreadAfter(&load->read, [variant] { SubmitLoadedVariant(variant); }, &shaderJobs);
+}
+
+void PrepareShaderVariant(ShaderVariant variant)
+{
+	ShaderVariantInfo& info = variants[(size_t)variant];
+
+	if (info.state == VariantUnrequested)
+	{
+		StartLoadingVariant(variant);
+	}
+}
+
+static void FinishVariant(ShaderVariant variant)
+{
+	PROFILE_SCOPE("Finish shader variant");
+	ShaderVariantInfo& info = variants[(size_t)variant];
+	WatchVariantFiles(variant, info.sources);
+
+	if (ProgramSuccess(info.building))
+	{
+		//The program keeps its own copy once linked
+		if (!info.fromBinary)
+		{
+			glDeleteShader(info.vertShader);
+			glDeleteShader(info.fragShader);
+
+			if (ProgramBinarySupported())
+			{
+				SaveProgramBinary(info.sources.key, info.building, true);
+			}
+		}
+
+		if (info.program != 0)
+		{
+			glDeleteProgram(info.program);
+			shaderPrograms.erase(std::remove(shaderPrograms.begin(), shaderPrograms.end(), (int)info.program), shaderPrograms.end());
+		}
+		else
+		{
+			liveVariantCount++;
+		}
+
+		shaderPrograms.push_back(info.building);
+		info.program = info.building;
+		info.building = 0;
+		info.state = VariantReady;
+		info.sources = VariantSources();
+		std::cout << "Built shader variant " << info.fragPath << " [" << info.defines << "], " << liveVariantCount << " of " << variants.size() << " variants live\n";
+		return;
+	}
+
+	//Read before the program goes, it is the only thing that explains a link error
+	char infoLog[512];
+	glGetProgramInfoLog(info.building, 512, nullptr, infoLog);
+	glDeleteProgram(info.building);
+
+	//A stale binary is not an error, build it again from the sources
+	if (info.fromBinary)
+	{
+		info.sources.binary.clear();
+		SubmitVariant(info);
+		return;
+	}
+
+	if (CheckShader(info.vertShader, VertShader, info.sources.vertFiles, info.defines.c_str()) && CheckShader(info.fragShader, FragShader, info.sources.fragFiles, info.defines.c_str()))
+	{
+		std::cout << "Shader Program linking failed! " << info.vertPath << " + " << info.fragPath << " [" << info.defines << "] LOG: " << infoLog << "\n";
+	}
+
+	glDeleteShader(info.vertShader);
+	glDeleteShader(info.fragShader);
+	EndFailedBuild(info);
+}
+
+void UpdateShaderVariants()
+{
+	//Loaded variants are submitted by main thread jobs, this only looks at the ones linking
+	for (size_t i = 0; i < variants.size(); i++)
+	{
+		ShaderVariant variant = (ShaderVariant)i;
+		ShaderVariantInfo& info = variants[i];
+
+		if (info.state == VariantLinking && LinkComplete(info.building))
+		{
+			FinishVariant(variant);
+		}
+
+		//Edited again while it was building
+		if (info.reloadQueued && (info.state == VariantReady || info.state == VariantFailed))
+		{
+			StartLoadingVariant(variant);
+		}
+	}
+}
+
+void WaitForShaderVariants()
+{
+	while (true)
+	{
+		bool building = false;
+
+		for (const ShaderVariantInfo& info : variants)
+		{
+			building |= info.state == VariantLoading || info.state == VariantLinking;
+		}
+
+		if (!building)
+		{
+			return;
+		}
+
+		RunMainThreadJobs();
+		UpdateShaderVariants();
+		std::this_thread::yield();
+	}
+}
+
+unsigned int GetShaderVariantProgram(ShaderVariant variant)
+{
+	ShaderVariantInfo& info = variants[(size_t)variant];
+
+	if (info.state == VariantUnrequested)
+	{
+		PrepareShaderVariant(variant);
+	}
+
+	return info.program != 0 ? info.program : fallbackProgram;
+}
+
+void ReloadChangedShaders()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	if (now - lastWatchTime < std::chrono::milliseconds(SHADER_WATCH_INTERVAL_MS))
+	{
+		return;
+	}
+
+	lastWatchTime = now;
+
+	for (std::pair<const string, std::filesystem::file_time_type>& file : watchedFiles)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type time = std::filesystem::last_write_time(file.first, error);
+
+		if (error || time == file.second)
+		{
+			continue;
+		}
+
+		file.second = time;
+		std::cout << "Shader file changed: " << file.first << "\n";
+
+		//Only the variants that read this file are rebuilt, they keep drawing with the old program meanwhile
+		for (ShaderVariant variant : fileDependents[file.first])
+		{
+			ShaderVariantInfo& info = variants[(size_t)variant];
+
+			if (info.state == VariantReady || info.state == VariantFailed)
+			{
+				StartLoadingVariant(variant);
+			}
+			else if (info.state != VariantUnrequested)
+			{
+				info.reloadQueued = true;
+			}
+		}
+	}
+}
+
+unsigned int GetShaderVariantCount()
+{
+	return (unsigned int)variants.size();
+}
+
+unsigned int GetLiveShaderVariantCount()
+{
+	return liveVariantCount;
 }
 
 void CleanupShaders()
 {
+	//Let background work finish before the objects it refers to go away, loads still running are submitted here too
+	WaitForCounter(shaderJobs);
+
+	for (ShaderVariantInfo& info : variants)
+	{
+		if (info.state == VariantLinking)
+		{
+			glDeleteProgram(info.building);
+			glDeleteShader(info.vertShader);
+			glDeleteShader(info.fragShader);
+		}
+	}
+
 	for (int i : vertShaders)
 	{
 		glDeleteShader(i);
@@ -149,4 +997,10 @@ void CleanupShaders()
 	vertShaders.clear();
 	fragShaders.clear();
 	shaderPrograms.clear();
+	variants.clear();
+	variantLookup.clear();
+	liveVariantCount = 0;
+	fallbackProgram = -1;
+	watchedFiles.clear();
+	fileDependents.clear();
 }
\ No newline at end of file
@@ -4,6 +4,33 @@ enum ShaderType { VertShader, FragShader };
 
 unsigned int CreateShader(ShaderType type, const char* filePath);
 unsigned int CreateShaderProgram(unsigned int vertShaderID, unsigned int fragShaderID);
+//Programs created from files are cached as driver binaries in shadercache/ and reloaded on later runs
 unsigned int CreateShaderProgram(const char* vertShaderPath, const char* fragShaderPath);
 
+//Variants, defines is a space separated list of names, each becomes a #define right after the #version line
+unsigned int CreateShader(ShaderType type, const char* filePath, const char* defines);
+unsigned int CreateShaderProgram(const char* vertShaderPath, const char* fragShaderPath, const char* defines);
+
+//Programs built the first time they are used, requests with the same sources and defines share one program.
+//A handle of its own type so it can't be mixed up with a GL program id.
+enum class ShaderVariant : unsigned int {};
+ShaderVariant GetShaderVariant(const char* vertShaderPath, const char* fragShaderPath, const char* defines);
+
+//Variants build in the background: files are read by a job and submitted from RunMainThreadJobs, the driver
+//compiles without being waited on and the results are checked on a later update. Call InitializeShaders once the context exists.
+void InitializeShaders();
+void PrepareShaderVariant(ShaderVariant variant);
+void UpdateShaderVariants();
+void WaitForShaderVariants();
+
+//Starts building the variant on the first call, returns the fallback program until it is ready or if it failed
+unsigned int GetShaderVariantProgram(ShaderVariant variant);
+
+//Shader files may #include "file" relative to themselves. Every file a variant was read from is watched,
+//and a change rebuilds only the variants that use it, the old program stays in use until the new one links.
+void ReloadChangedShaders();
+
+unsigned int GetShaderVariantCount();
+unsigned int GetLiveShaderVariantCount();
+
 void CleanupShaders();
\ No newline at end of file
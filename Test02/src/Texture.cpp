@@ -2,7 +2,9 @@
 #include <glfw3.h>
 #include <vector>
 #include <iostream>
+#include <string>
 #include "Texture.h"
+#include "Profiler.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -20,6 +22,33 @@ unsigned int LoadTexture(const char* path)
 
 unsigned int LoadTexture(const char* path, unsigned int wrapMode)
 {
+	TextureImage image = DecodeTexture(path);
+	return UploadTexture(image, wrapMode);
+}
+
+TextureImage DecodeTexture(const char* path)
+{
+	PROFILE_SCOPE("Decode texture");
+
+	//Load texture from file, the flip setting is per thread so decodes can run side by side
+	TextureImage image = {};
+	stbi_set_flip_vertically_on_load_thread(true);
+
+	image.pixels = stbi_load(path, &image.width, &image.height, &image.channels, 0);
+
+	std::cout << std::string("Load Texture @") + path + "	nrChannels = " + std::to_string(image.channels) + "\n";
+
+	return image;
+}
+
+unsigned int UploadTexture(TextureImage& image, unsigned int wrapMode)
+{
+	if (!image.pixels)
+	{
+		std::cout << "Image load failed!" << std::endl;
+		return -1;
+	}
+
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_2D, textureID);
@@ -30,36 +59,22 @@ unsigned int LoadTexture(const char* path, unsigned int wrapMode)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	//Load texture from file
-	int width, height, nrChannels;
-	stbi_set_flip_vertically_on_load(true);
-
-	unsigned char* textureData = stbi_load(path, &width, &height, &nrChannels, 0);
-
-	std::cout << "Load Texture @" << path << "	nrChannels = " << nrChannels << std::endl;
-
 	unsigned int imageFormat = 0;
 
-	switch (nrChannels)
+	switch (image.channels)
 	{
 	case 2: imageFormat = GL_RG; break;
 	case 3: imageFormat = GL_RGB; break;
 	case 4: imageFormat = GL_RGBA; break;
 	}
 
-	if (textureData)
-	{
-		//Bind image to texture
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, imageFormat, GL_UNSIGNED_BYTE, textureData);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Image load failed!" << std::endl;
-		stbi_image_free(textureData);
-		return -1;
-	}
+	//Bind image to texture
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, imageFormat, GL_UNSIGNED_BYTE, image.pixels);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	stbi_image_free(image.pixels);
+	image.pixels = nullptr;
 
 	return textureID;
 }
\ No newline at end of file
@@ -1,5 +1,14 @@
 #pragma once
 
+//Pixels decoded on any thread, waiting for UploadTexture on the GL thread
+struct TextureImage
+{
+	unsigned char* pixels;
+	int width, height, channels;
+};
 
 unsigned int LoadTexture(const char* path);
-unsigned int LoadTexture(const char* path, unsigned int wrapMode);
\ No newline at end of file
+unsigned int LoadTexture(const char* path, unsigned int wrapMode);
+TextureImage DecodeTexture(const char* path);
+//Frees the pixels, returns -1 when the image failed to decode
+unsigned int UploadTexture(TextureImage& image, unsigned int wrapMode);
\ No newline at end of file
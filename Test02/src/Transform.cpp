@@ -0,0 +1,344 @@
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+#include "Transform.h"
+#include "TransformBatch.h"
+#include "JobSystem.h"
+
+using glm::vec3;
+using glm::mat3;
+
+//Smallest share of a level handed to a job, smaller ones cost more to hand out than they save
+#define TRANSFORM_JOB_MIN 4096
+
+//Node data by slot, slots are kept sorted by depth
+static std::vector<int> parents;
+static std::vector<unsigned int> depths;
+//One array per component so local transforms can be built four at a time
+static std::vector<float> positions[3];
+static std::vector<float> rotations[3];
+static std::vector<float> scales[3];
+static std::vector<Affine> localTransforms;
+static std::vector<Affine> worldTransforms;
+//Normal matrices are only needed for nodes that get drawn, so they are built when first asked for
+static std::vector<mat3> worldNormals;
+static std::vector<unsigned char> normalDirty;
+//World transform scales every axis alike, so its normal matrix needs no inverse
+static std::vector<unsigned char> uniformScales;
+//Local transform needs rebuilding
+static std::vector<unsigned char> localDirty;
+//World transform was rebuilt by the running update, read by the children
+static std::vector<unsigned char> worldChanged;
+
+//Handles map to slots so slots can move when the order is restored
+static std::vector<unsigned int> handleSlots;
+static std::vector<Transform> slotHandles;
+
+static bool anyDirty = false;
+static bool orderDirty = false;
+
+template<typename T> static void Permute(std::vector<T>& values, const std::vector<unsigned int>& order)
+{
+	std::vector<T> sorted(values.size());
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		sorted[i] = values[order[i]];
+	}
+
+	values.swap(sorted);
+}
+
+//Reparenting can move a subtree to a different depth, a stable sort by depth puts parents first again
+static void SortTransforms()
+{
+	unsigned int count = (unsigned int)parents.size();
+
+	for (unsigned int slot = 0; slot < count; slot++)
+	{
+		unsigned int depth = 0;
+
+		for (int parent = parents[slot]; parent != -1; parent = parents[parent])
+		{
+			depth++;
+		}
+
+		depths[slot] = depth;
+	}
+
+	std::vector<unsigned int> order(count);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [](unsigned int a, unsigned int b) { return depths[a] < depths[b]; });
+
+	std::vector<int> newSlots(count);
+
+	for (unsigned int slot = 0; slot < count; slot++)
+	{
+		newSlots[order[slot]] = slot;
+	}
+
+	for (int& parent : parents)
+	{
+		parent = parent == -1 ? -1 : newSlots[parent];
+	}
+
+	Permute(parents, order);
+	Permute(depths, order);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		Permute(positions[axis], order);
+		Permute(rotations[axis], order);
+		Permute(scales[axis], order);
+	}
+
+	Permute(localTransforms, order);
+	Permute(worldTransforms, order);
+	Permute(worldNormals, order);
+	Permute(normalDirty, order);
+	Permute(uniformScales, order);
+	Permute(localDirty, order);
+	Permute(slotHandles, order);
+
+	for (unsigned int slot = 0; slot < count; slot++)
+	{
+		handleSlots[slotHandles[slot]] = slot;
+	}
+
+	orderDirty = false;
+}
+
+Transform CreateTransform(Transform parent)
+{
+	Transform transform = (Transform)handleSlots.size();
+	int parentSlot = parent == NO_TRANSFORM ? -1 : (int)handleSlots[parent];
+	unsigned int depth = parentSlot == -1 ? 0 : depths[parentSlot] + 1;
+
+	if (!depths.empty() && depth < depths.back())
+	{
+		orderDirty = true;
+	}
+
+	handleSlots.push_back((unsigned int)parents.size());
+	slotHandles.push_back(transform);
+	parents.push_back(parentSlot);
+	depths.push_back(depth);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		positions[axis].push_back(0.f);
+		rotations[axis].push_back(0.f);
+		scales[axis].push_back(1.f);
+	}
+
+	localTransforms.push_back(IdentityAffine());
+	worldTransforms.push_back(IdentityAffine());
+	worldNormals.push_back(mat3(1.f));
+	normalDirty.push_back(1);
+	uniformScales.push_back(1);
+	localDirty.push_back(1);
+	worldChanged.push_back(0);
+	anyDirty = true;
+
+	return transform;
+}
+
+void SetTransformParent(Transform transform, Transform parent)
+{
+	unsigned int slot = handleSlots[transform];
+	int parentSlot = parent == NO_TRANSFORM ? -1 : (int)handleSlots[parent];
+
+	//A node can't end up below itself
+	for (int ancestor = parentSlot; ancestor != -1; ancestor = parents[ancestor])
+	{
+		if (ancestor == (int)slot)
+		{
+			std::cout << "Can't parent transform " << transform << " to its own descendant " << parent << "\n";
+			return;
+		}
+	}
+
+	parents[slot] = parentSlot;
+	localDirty[slot] = 1;
+	anyDirty = true;
+	orderDirty = true;
+}
+
+Transform GetTransformParent(Transform transform)
+{
+	int parent = parents[handleSlots[transform]];
+	return parent == -1 ? NO_TRANSFORM : slotHandles[parent];
+}
+
+void ClearTransforms()
+{
+	parents.clear();
+	depths.clear();
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		positions[axis].clear();
+		rotations[axis].clear();
+		scales[axis].clear();
+	}
+
+	localTransforms.clear();
+	worldTransforms.clear();
+	worldNormals.clear();
+	normalDirty.clear();
+	uniformScales.clear();
+	localDirty.clear();
+	worldChanged.clear();
+	handleSlots.clear();
+	slotHandles.clear();
+	anyDirty = false;
+	orderDirty = false;
+}
+
+unsigned int GetTransformCount()
+{
+	return (unsigned int)parents.size();
+}
+
+void SetTransformPosition(Transform transform, glm::vec3 position)
+{
+	unsigned int slot = handleSlots[transform];
+	positions[0][slot] = position.x;
+	positions[1][slot] = position.y;
+	positions[2][slot] = position.z;
+	localDirty[slot] = 1;
+	anyDirty = true;
+}
+
+void SetTransformRotation(Transform transform, glm::vec3 eulerRotation)
+{
+	unsigned int slot = handleSlots[transform];
+	rotations[0][slot] = eulerRotation.x;
+	rotations[1][slot] = eulerRotation.y;
+	rotations[2][slot] = eulerRotation.z;
+	localDirty[slot] = 1;
+	anyDirty = true;
+}
+
+void SetTransformScale(Transform transform, glm::vec3 scale)
+{
+	unsigned int slot = handleSlots[transform];
+	scales[0][slot] = scale.x;
+	scales[1][slot] = scale.y;
+	scales[2][slot] = scale.z;
+	localDirty[slot] = 1;
+	anyDirty = true;
+}
+
+glm::vec3 GetTransformPosition(Transform transform)
+{
+	unsigned int slot = handleSlots[transform];
+	return vec3(positions[0][slot], positions[1][slot], positions[2][slot]);
+}
+
+glm::vec3 GetTransformRotation(Transform transform)
+{
+	unsigned int slot = handleSlots[transform];
+	return vec3(rotations[0][slot], rotations[1][slot], rotations[2][slot]);
+}
+
+glm::vec3 GetTransformScale(Transform transform)
+{
+	unsigned int slot = handleSlots[transform];
+	return vec3(scales[0][slot], scales[1][slot], scales[2][slot]);
+}
+
+//Every parent in the range is at the level above, so slots in a level can be updated in any order
+static void UpdateTransformRange(unsigned int first, unsigned int last)
+{
+	//Local transforms of the changed slots are built together first, the buffers are kept per thread
+	static thread_local std::vector<unsigned int> dirtySlots;
+	static thread_local std::vector<Affine> dirtyTransforms;
+	dirtySlots.clear();
+
+	for (unsigned int slot = first; slot < last; slot++)
+	{
+		if (localDirty[slot])
+		{
+			dirtySlots.push_back(slot);
+		}
+	}
+
+	if (!dirtySlots.empty())
+	{
+		TransformArrays arrays = { { positions[0].data(), positions[1].data(), positions[2].data() },
+			{ rotations[0].data(), rotations[1].data(), rotations[2].data(), nullptr }, { scales[0].data(), scales[1].data(), scales[2].data() } };
+		dirtyTransforms.resize(dirtySlots.size());
+		BuildAffineTransforms(arrays, EulerRotation, dirtySlots.data(), (unsigned int)dirtySlots.size(), dirtyTransforms.data());
+
+		for (size_t i = 0; i < dirtySlots.size(); i++)
+		{
+			localTransforms[dirtySlots[i]] = dirtyTransforms[i];
+		}
+	}
+
+	for (unsigned int slot = first; slot < last; slot++)
+	{
+		int parent = parents[slot];
+		bool changed = localDirty[slot] || (parent != -1 && worldChanged[parent]);
+		worldChanged[slot] = changed;
+		localDirty[slot] = 0;
+
+		if (changed)
+		{
+			worldTransforms[slot] = parent == -1 ? localTransforms[slot] : ComposeAffine(worldTransforms[parent], localTransforms[slot]);
+			uniformScales[slot] = scales[0][slot] == scales[1][slot] && scales[1][slot] == scales[2][slot] && (parent == -1 || uniformScales[parent]);
+			normalDirty[slot] = 1;
+		}
+	}
+}
+
+void UpdateTransforms()
+{
+	if (!anyDirty)
+	{
+		return;
+	}
+
+	if (orderDirty)
+	{
+		SortTransforms();
+	}
+
+	unsigned int count = (unsigned int)parents.size();
+
+	for (unsigned int levelStart = 0; levelStart < count;)
+	{
+		unsigned int levelEnd = (unsigned int)(std::upper_bound(depths.begin() + levelStart, depths.end(), depths[levelStart]) - depths.begin());
+
+		//The level has to finish before the next one reads it
+		ParallelFor(levelStart, levelEnd, TRANSFORM_JOB_MIN, UpdateTransformRange);
+		levelStart = levelEnd;
+	}
+
+	anyDirty = false;
+}
+
+const Affine& GetWorldTransform(Transform transform)
+{
+	return worldTransforms[handleSlots[transform]];
+}
+
+const glm::mat3& GetWorldNormalMatrix(Transform transform)
+{
+	unsigned int slot = handleSlots[transform];
+
+	if (normalDirty[slot])
+	{
+		worldNormals[slot] = uniformScales[slot] ? GetUniformScaleNormalMatrix(worldTransforms[slot]) : GetNormalMatrix(worldTransforms[slot]);
+		normalDirty[slot] = 0;
+	}
+
+	return worldNormals[slot];
+}
+
+glm::vec3 GetWorldPosition(Transform transform)
+{
+	return GetAffinePosition(worldTransforms[handleSlots[transform]]);
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "Affine.h"
+
+//Handle to a node in the transform hierarchy, stays valid when nodes are added or reparented
+typedef unsigned int Transform;
+#define NO_TRANSFORM ((Transform)-1)
+
+//Nodes live in parent indexed arrays sorted by depth, so every parent comes before its children.
+//Changing a node only marks it dirty, UpdateTransforms then rebuilds the world transforms of dirty nodes
+//and everything below them, one depth level at a time with large levels split across the job threads.
+Transform CreateTransform(Transform parent);
+void SetTransformParent(Transform transform, Transform parent);
+Transform GetTransformParent(Transform transform);
+void ClearTransforms();
+unsigned int GetTransformCount();
+
+//Local to the parent, rotation is euler angles in degrees
+void SetTransformPosition(Transform transform, glm::vec3 position);
+void SetTransformRotation(Transform transform, glm::vec3 eulerRotation);
+void SetTransformScale(Transform transform, glm::vec3 scale);
+glm::vec3 GetTransformPosition(Transform transform);
+glm::vec3 GetTransformRotation(Transform transform);
+glm::vec3 GetTransformScale(Transform transform);
+
+void UpdateTransforms();
+
+//As of the last UpdateTransforms
+const Affine& GetWorldTransform(Transform transform);
+//Rebuilt on the first read after the world transform changes, nodes scaled uniformly all the way up skip the inverse
+const glm::mat3& GetWorldNormalMatrix(Transform transform);
+glm::vec3 GetWorldPosition(Transform transform);
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include <cmath>
+#include "TransformBatch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORMS_USE_SSE
+#endif
+
+#define DEGREES_TO_RADIANS 0.01745329252f
+
+//Matrix elements in row major 3x4 order
+enum { M00, M01, M02, M03, M10, M11, M12, M13, M20, M21, M22, M23 };
+
+#ifdef TRANSFORMS_USE_SSE
+//Sine and cosine of four angles. The angle is reduced by the nearest multiple of pi/2 in two steps so
+//large angles keep their precision, then both are evaluated on -pi/4..pi/4 and swapped or negated by quadrant.
+static void SinCos(__m128 x, __m128& sine, __m128& cosine)
+{
+	__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772f)));
+	__m128 multiple = _mm_cvtepi32_ps(quadrant);
+	x = _mm_sub_ps(x, _mm_mul_ps(multiple, _mm_set1_ps(1.5703125f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(multiple, _mm_set1_ps(4.83826794897e-4f)));
+	__m128 x2 = _mm_mul_ps(x, x);
+
+	__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), x2), _mm_set1_ps(8.3321608736e-3f));
+	s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.6666654611e-1f));
+	s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+
+	__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), x2), _mm_set1_ps(-1.388731625493765e-3f));
+	c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(4.166664568298827e-2f));
+	c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, x2), x2), _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(x2, _mm_set1_ps(0.5f))));
+
+	//Odd quadrants swap sine and cosine, sine flips in quadrants 2 and 3, cosine in 1 and 2
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	__m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+	__m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+	sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sineSign);
+	cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosineSign);
+}
+
+//One component of four transforms, from the lane indices or straight from first when they are contiguous
+static __m128 Gather(const float* values, const unsigned int* lanes, unsigned int first)
+{
+	return lanes ? _mm_setr_ps(values[lanes[0]], values[lanes[1]], values[lanes[2]], values[lanes[3]]) : _mm_loadu_ps(values + first);
+}
+
+//Rotation elements of four transforms, in the same order as the matrix layout without the translation column
+static void BuildRotations(const TransformArrays& arrays, RotationMode mode, const unsigned int* lanes, unsigned int first, __m128 rotation[9])
+{
+	if (mode == EulerRotation)
+	{
+		__m128 sinPitch, cosPitch, sinYaw, cosYaw, sinRoll, cosRoll;
+		SinCos(_mm_mul_ps(Gather(arrays.rotation[0], lanes, first), _mm_set1_ps(DEGREES_TO_RADIANS)), sinPitch, cosPitch);
+		SinCos(_mm_mul_ps(Gather(arrays.rotation[1], lanes, first), _mm_set1_ps(DEGREES_TO_RADIANS)), sinYaw, cosYaw);
+		SinCos(_mm_mul_ps(Gather(arrays.rotation[2], lanes, first), _mm_set1_ps(DEGREES_TO_RADIANS)), sinRoll, cosRoll);
+
+		__m128 sinPitchSinRoll = _mm_mul_ps(sinPitch, sinRoll);
+		__m128 sinPitchCosRoll = _mm_mul_ps(sinPitch, cosRoll);
+		rotation[0] = _mm_add_ps(_mm_mul_ps(cosYaw, cosRoll), _mm_mul_ps(sinYaw, sinPitchSinRoll));
+		rotation[1] = _mm_sub_ps(_mm_mul_ps(sinYaw, sinPitchCosRoll), _mm_mul_ps(cosYaw, sinRoll));
+		rotation[2] = _mm_mul_ps(sinYaw, cosPitch);
+		rotation[3] = _mm_mul_ps(sinRoll, cosPitch);
+		rotation[4] = _mm_mul_ps(cosRoll, cosPitch);
+		rotation[5] = _mm_sub_ps(_mm_setzero_ps(), sinPitch);
+		rotation[6] = _mm_sub_ps(_mm_mul_ps(cosYaw, sinPitchSinRoll), _mm_mul_ps(sinYaw, cosRoll));
+		rotation[7] = _mm_add_ps(_mm_mul_ps(sinRoll, sinYaw), _mm_mul_ps(cosYaw, sinPitchCosRoll));
+		rotation[8] = _mm_mul_ps(cosYaw, cosPitch);
+		return;
+	}
+
+	__m128 x = Gather(arrays.rotation[0], lanes, first);
+	__m128 y = Gather(arrays.rotation[1], lanes, first);
+	__m128 z = Gather(arrays.rotation[2], lanes, first);
+	__m128 w = Gather(arrays.rotation[3], lanes, first);
+	__m128 two = _mm_set1_ps(2.f);
+	__m128 one = _mm_set1_ps(1.f);
+	__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+	__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+	__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+	rotation[0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+	rotation[1] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+	rotation[2] = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+	rotation[3] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+	rotation[4] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+	rotation[5] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+	rotation[6] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+	rotation[7] = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+	rotation[8] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+}
+
+//Elements of four transforms, one element of each per register in the row major layout
+static void BuildElements(const TransformArrays& arrays, RotationMode mode, const unsigned int* lanes, unsigned int first, __m128 elements[12])
+{
+	__m128 rotation[9];
+	BuildRotations(arrays, mode, lanes, first, rotation);
+
+	for (int row = 0; row < 3; row++)
+	{
+		__m128 scale = Gather(arrays.scale[row], lanes, first);
+		elements[row * 4] = _mm_mul_ps(rotation[row * 3], scale);
+		elements[row * 4 + 1] = _mm_mul_ps(rotation[row * 3 + 1], scale);
+		elements[row * 4 + 2] = _mm_mul_ps(rotation[row * 3 + 2], scale);
+		elements[row * 4 + 3] = Gather(arrays.position[row], lanes, first);
+	}
+}
+
+//Runs the builder over every four transforms and hands the elements to store
+template<typename Store> static void BuildTransforms(const TransformArrays& arrays, RotationMode mode, const unsigned int* indices, unsigned int count, Store store)
+{
+	for (unsigned int first = 0; first < count; first += 4)
+	{
+		unsigned int laneCount = count - first < 4 ? count - first : 4;
+		unsigned int lanes[4];
+		const unsigned int* laneIndices = nullptr;
+
+		//The tail repeats its last transform so every lane reads something valid
+		if (indices || laneCount < 4)
+		{
+			for (unsigned int lane = 0; lane < 4; lane++)
+			{
+				unsigned int element = first + (lane < laneCount ? lane : laneCount - 1);
+				lanes[lane] = indices ? indices[element] : element;
+			}
+
+			laneIndices = lanes;
+		}
+
+		__m128 elements[12];
+		BuildElements(arrays, mode, laneIndices, first, elements);
+		store(first, laneCount, elements);
+	}
+}
+#else
+static void BuildRow(const TransformArrays& arrays, RotationMode mode, unsigned int index, float rows[12])
+{
+	float rotation[9];
+
+	if (mode == EulerRotation)
+	{
+		float pitch = arrays.rotation[0][index] * DEGREES_TO_RADIANS;
+		float yaw = arrays.rotation[1][index] * DEGREES_TO_RADIANS;
+		float roll = arrays.rotation[2][index] * DEGREES_TO_RADIANS;
+		float sinPitch = std::sin(pitch), cosPitch = std::cos(pitch);
+		float sinYaw = std::sin(yaw), cosYaw = std::cos(yaw);
+		float sinRoll = std::sin(roll), cosRoll = std::cos(roll);
+
+		rotation[0] = cosYaw * cosRoll + sinYaw * sinPitch * sinRoll;
+		rotation[1] = sinYaw * sinPitch * cosRoll - cosYaw * sinRoll;
+		rotation[2] = sinYaw * cosPitch;
+		rotation[3] = sinRoll * cosPitch;
+		rotation[4] = cosRoll * cosPitch;
+		rotation[5] = -sinPitch;
+		rotation[6] = cosYaw * sinPitch * sinRoll - sinYaw * cosRoll;
+		rotation[7] = sinRoll * sinYaw + cosYaw * sinPitch * cosRoll;
+		rotation[8] = cosYaw * cosPitch;
+	}
+	else
+	{
+		float x = arrays.rotation[0][index], y = arrays.rotation[1][index], z = arrays.rotation[2][index], w = arrays.rotation[3][index];
+
+		rotation[0] = 1.f - 2.f * (y * y + z * z);
+		rotation[1] = 2.f * (x * y - w * z);
+		rotation[2] = 2.f * (x * z + w * y);
+		rotation[3] = 2.f * (x * y + w * z);
+		rotation[4] = 1.f - 2.f * (x * x + z * z);
+		rotation[5] = 2.f * (y * z - w * x);
+		rotation[6] = 2.f * (x * z - w * y);
+		rotation[7] = 2.f * (y * z + w * x);
+		rotation[8] = 1.f - 2.f * (x * x + y * y);
+	}
+
+	for (int row = 0; row < 3; row++)
+	{
+		float scale = arrays.scale[row][index];
+		rows[row * 4] = rotation[row * 3] * scale;
+		rows[row * 4 + 1] = rotation[row * 3 + 1] * scale;
+		rows[row * 4 + 2] = rotation[row * 3 + 2] * scale;
+		rows[row * 4 + 3] = arrays.position[row][index];
+	}
+}
+#endif
+
+#ifdef TRANSFORMS_USE_SSE
+void BuildAffineTransforms(const TransformArrays& arrays, RotationMode mode, const unsigned int* indices, unsigned int count, Affine* transforms)
+{
+	BuildTransforms(arrays, mode, indices, count, [transforms](unsigned int first, unsigned int laneCount, __m128 elements[12])
+	{
+		//Each row of the four transforms becomes one register per transform
+		for (int row = 0; row < 3; row++)
+		{
+			_MM_TRANSPOSE4_PS(elements[row * 4], elements[row * 4 + 1], elements[row * 4 + 2], elements[row * 4 + 3]);
+		}
+
+		for (unsigned int lane = 0; lane < laneCount; lane++)
+		{
+			Affine& transform = transforms[first + lane];
+			_mm_storeu_ps(&transform.rows[0].x, elements[lane]);
+			_mm_storeu_ps(&transform.rows[1].x, elements[4 + lane]);
+			_mm_storeu_ps(&transform.rows[2].x, elements[8 + lane]);
+		}
+	});
+}
+
+void BuildTransformMatrices(const TransformArrays& arrays, RotationMode mode, const unsigned int* indices, unsigned int count, glm::mat4* matrices)
+{
+	BuildTransforms(arrays, mode, indices, count, [matrices](unsigned int first, unsigned int laneCount, __m128 elements[12])
+	{
+		//Columns are the three rows of one element plus the affine bottom row
+		for (int column = 0; column < 4; column++)
+		{
+			__m128 x = elements[column], y = elements[4 + column], z = elements[8 + column];
+			__m128 w = column == 3 ? _mm_set1_ps(1.f) : _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			__m128 columns[4] = { x, y, z, w };
+
+			for (unsigned int lane = 0; lane < laneCount; lane++)
+			{
+				_mm_storeu_ps(&matrices[first + lane][column][0], columns[lane]);
+			}
+		}
+	});
+}
+#else
+void BuildAffineTransforms(const TransformArrays& arrays, RotationMode mode, const unsigned int* indices, unsigned int count, Affine* transforms)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		BuildRow(arrays, mode, indices ? indices[i] : i, &transforms[i].rows[0].x);
+	}
+}
+
+void BuildTransformMatrices(const TransformArrays& arrays, RotationMode mode, const unsigned int* indices, unsigned int count, glm::mat4* matrices)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		float transform[12];
+		BuildRow(arrays, mode, indices ? indices[i] : i, transform);
+
+		glm::mat4& matrix = matrices[i];
+		matrix[0] = glm::vec4(transform[M00], transform[M10], transform[M20], 0.f);
+		matrix[1] = glm::vec4(transform[M01], transform[M11], transform[M21], 0.f);
+		matrix[2] = glm::vec4(transform[M02], transform[M12], transform[M22], 0.f);
+		matrix[3] = glm::vec4(transform[M03], transform[M13], transform[M23], 1.f);
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "Affine.h"
+
+enum RotationMode { EulerRotation, QuaternionRotation };
+
+//Local transforms as one array per component. Rotation is euler degrees applied like glm::eulerAngleYXZ,
+//or a unit quaternion with the w array in rotation[3].
+struct TransformArrays
+{
+	const float* position[3];
+	const float* rotation[4];
+	const float* scale[3];
+};
+
+//Builds translate * scale * rotate for count transforms, four at a time with SSE.
+//indices picks which elements to read, null reads the first count, output i is always for input i.
+void BuildAffineTransforms(const TransformArrays& arrays, RotationMode mode, const unsigned int* indices, unsigned int count, Affine* transforms);
+void BuildTransformMatrices(const TransformArrays& arrays, RotationMode mode, const unsigned int* indices, unsigned int count, glm::mat4* matrices);
\ No newline at end of file